@@ -0,0 +1,463 @@
+#include <ssd1306_ascii_pico/ssd1306_ascii_emulator.h>
+#include <ssd1306_ascii_pico/ssd1306_ascii_mock.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef BENCH_FONT_SUBSET
+#include <ssd1306_fonts/Arial14_bench.h>
+#endif // BENCH_FONT_SUBSET
+
+// Display with the state of its ticker.
+class BenchDisplay : public SSD1306AsciiI2C
+{
+  public:
+    explicit BenchDisplay(I2CBusInterface &bus) : SSD1306AsciiI2C(bus)
+    {
+    }
+    TickerState ticker = {};
+    uint8_t frame[128 * 8];
+    uint16_t hashes[8 * 128 / SEGMENT_HASH_COLS];
+    uint8_t scratch[128];
+};
+
+// How a case reaches the controller.
+enum BenchMode : uint8_t
+{
+    DIRECT, // Write to the controller.
+    FRAME,  // Render into a frame buffer.
+    HASHED  // Render page by page with segment hashes.
+};
+
+// Each case renders one frame, the same frame on every iteration. A case
+// with a reference must show the pixels of the reference, which draws the
+// same frame with the source font through the plain path. Cases run on an
+// SSD1306 panel unless they name another device.
+struct BenchCase
+{
+    const char *name;
+    void (*render)(BenchDisplay &oled);
+    BenchMode mode;
+    void (*reference)(BenchDisplay &oled) = nullptr;
+    const DevType *dev = &Adafruit128x64;
+};
+
+static void drawCase(SSD1306Ascii &display, void *ctx)
+{
+    ((const BenchCase *)ctx)->render(static_cast<BenchDisplay &>(display));
+}
+
+static void setMode(BenchDisplay &oled, BenchMode mode)
+{
+    if (mode == FRAME)
+    {
+        oled.setFrameBuffer(oled.frame, sizeof(oled.frame));
+    }
+    else if (mode == HASHED)
+    {
+        oled.setSegmentHashes(oled.hashes, sizeof(oled.hashes) / sizeof(oled.hashes[0]),
+                              oled.scratch, sizeof(oled.scratch));
+    }
+    else
+    {
+        oled.setFrameBuffer(nullptr, 0);
+    }
+}
+
+// Render one frame and wait until it is on the bus.
+static void renderFrame(BenchDisplay &oled, const BenchCase &c)
+{
+    oled.render(drawCase, (void *)&c);
+    oled.flush();
+}
+
+static void renderClear(BenchDisplay &oled)
+{
+    oled.clear();
+}
+
+static void renderText1X(BenchDisplay &oled)
+{
+    oled.setFont(Adafruit5x7);
+    oled.set1X();
+    for (uint8_t row = 0; row < oled.displayRows(); row++)
+    {
+        oled.setCursor(0, row);
+        oled.print("0123456789ABCDEFGHIJ");
+    }
+}
+
+static void renderText2X(BenchDisplay &oled)
+{
+    oled.setFont(Adafruit5x7);
+    oled.set2X();
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("0123456789");
+    }
+    oled.set1X();
+}
+
+static GlyphCache<24, 2048> glyphCache;
+
+static void renderText2XCached(BenchDisplay &oled)
+{
+    oled.setGlyphCache(&glyphCache);
+    renderText2X(oled);
+    oled.setGlyphCache(nullptr);
+}
+
+static void renderProportional(BenchDisplay &oled)
+{
+    oled.setFont(Arial14);
+    oled.set1X();
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("Hello World! 42.0");
+    }
+}
+
+static uint8_t arenaBuf[2048];
+static FontArena arena(arenaBuf, sizeof(arenaBuf));
+
+static void renderArena(BenchDisplay &oled)
+{
+    oled.setFontArena(&arena);
+    renderProportional(oled);
+    oled.setFontArena(nullptr);
+}
+
+static void renderPaged(BenchDisplay &oled)
+{
+    oled.setFont(pagedFont<Arial14>);
+    oled.set1X();
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("Hello World! 42.0");
+    }
+}
+
+#ifdef BENCH_FONT_SUBSET
+static void renderSubset(BenchDisplay &oled)
+{
+    oled.setFont(Arial14_bench);
+    oled.set1X();
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("Hello World! 42.0");
+    }
+}
+#endif // BENCH_FONT_SUBSET
+
+static void renderUtf8(BenchDisplay &oled)
+{
+    oled.setFont(utf8font10x16);
+    oled.set1X();
+    oled.setUtf8Mode(true);
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("21.5\xC2\xB0" "C M\xC3\xA4rz");
+    }
+    oled.setUtf8Mode(false);
+}
+
+static void renderSparse(BenchDisplay &oled)
+{
+    oled.setFont(sparseFont<utf8font10x16, ' ', '.', '0', '9', 'C', 'C', 'M', 'M', 'a', 'a', 'r', 'r',
+                            'z', 'z', 0XB0, 0XB0, 0XE4, 0XE4>);
+    oled.set1X();
+    oled.setUtf8Mode(true);
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("21.5\xC2\xB0" "C M\xC3\xA4rz");
+    }
+    oled.setUtf8Mode(false);
+}
+
+static FontChain fontChain(Verdana12, utf8font10x16);
+
+static void renderChain(BenchDisplay &oled)
+{
+    oled.setFontChain(&fontChain);
+    oled.set1X();
+    oled.setUtf8Mode(true);
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("T 21.5\xC2\xB0" "C M\xC3\xA4rz");
+    }
+    oled.setUtf8Mode(false);
+    oled.setFontChain(nullptr);
+}
+
+static void renderVerdana(BenchDisplay &oled)
+{
+    oled.setFont(Verdana12);
+    oled.set1X();
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("xyz~}|{wvu");
+    }
+}
+
+static void renderVerdanaIndexed(BenchDisplay &oled)
+{
+    oled.setFont(glyphIndex<Verdana12>);
+    oled.set1X();
+    for (uint8_t row = 0; row < oled.displayRows(); row += 2)
+    {
+        oled.setCursor(0, row);
+        oled.print("xyz~}|{wvu");
+    }
+}
+
+static void renderBigNums(BenchDisplay &oled)
+{
+    oled.setFont(lcdnums14x24);
+    oled.setMag(3, 2);
+    oled.setCursor(0, 0);
+    oled.print("12");
+    oled.set1X();
+}
+
+static void renderBigNumsPaged(BenchDisplay &oled)
+{
+    oled.setFont(pagedFont<lcdnums14x24, 3, 2>);
+    oled.setCursor(0, 0);
+    oled.print("12");
+}
+
+static void renderCalBlk(BenchDisplay &oled)
+{
+    oled.setFont(CalBlk36);
+    oled.set1X();
+    oled.setCursor(0, 0);
+    oled.print("12 45");
+}
+
+static void renderCalBlkRle(BenchDisplay &oled)
+{
+    oled.setFont(rleFont<CalBlk36>);
+    oled.set1X();
+    oled.setCursor(0, 0);
+    oled.print("12 45");
+}
+
+static void renderCalBlk2X(BenchDisplay &oled)
+{
+    oled.setFont(CalBlk36);
+    oled.set2X();
+    oled.setCursor(0, 0);
+    oled.print("12");
+    oled.set1X();
+}
+
+static void renderCalBlkRle2X(BenchDisplay &oled)
+{
+    oled.setFont(rleFont<CalBlk36>);
+    oled.set2X();
+    oled.setCursor(0, 0);
+    oled.print("12");
+    oled.set1X();
+}
+
+static void renderField(BenchDisplay &oled)
+{
+    oled.setFont(Arial14);
+    oled.set1X();
+    oled.clearField(64, 2, 4);
+    oled.print("12.5");
+}
+
+static void renderTicker(BenchDisplay &oled)
+{
+    if (!oled.ticker.font)
+    {
+        oled.tickerInit(&oled.ticker, Adafruit5x7, 6, true);
+    }
+    if (!oled.tickerTick(&oled.ticker))
+    {
+        oled.tickerText(&oled.ticker, "A ticker on the bottom rows. ");
+    }
+}
+
+static void renderTickerCached(BenchDisplay &oled)
+{
+    oled.setGlyphCache(&glyphCache);
+    renderTicker(oled);
+    oled.setGlyphCache(nullptr);
+}
+
+static const BenchCase cases[] = {
+    {"clear", renderClear, DIRECT},
+    {"text 1X", renderText1X, DIRECT},
+    {"text 1X sh1106", renderText1X, DIRECT, nullptr, &SH1106_128x64},
+    {"text 2X", renderText2X, DIRECT},
+    {"text 2X cache", renderText2XCached, DIRECT, renderText2X},
+    {"proportional", renderProportional, DIRECT},
+    {"arena", renderArena, DIRECT, renderProportional},
+    {"paged", renderPaged, DIRECT, renderProportional},
+#ifdef BENCH_FONT_SUBSET
+    {"subset", renderSubset, DIRECT, renderProportional},
+#endif // BENCH_FONT_SUBSET
+    {"utf8", renderUtf8, DIRECT},
+    {"utf8 sparse", renderSparse, DIRECT, renderUtf8},
+    {"font chain", renderChain, DIRECT},
+    {"verdana", renderVerdana, DIRECT},
+    {"verdana idx", renderVerdanaIndexed, DIRECT, renderVerdana},
+    {"nums 3x2", renderBigNums, DIRECT},
+    {"nums paged", renderBigNumsPaged, DIRECT, renderBigNums},
+    {"calblk36", renderCalBlk, DIRECT},
+    {"calblk36 rle", renderCalBlkRle, DIRECT, renderCalBlk},
+    {"calblk36 2X", renderCalBlk2X, DIRECT},
+    {"calblk36 rle2X", renderCalBlkRle2X, DIRECT, renderCalBlk2X},
+    {"field", renderField, DIRECT},
+    {"ticker", renderTicker, DIRECT},
+    {"ticker cache", renderTickerCached, DIRECT, renderTicker},
+    {"clear fb", renderClear, FRAME},
+    {"text 1X fb", renderText1X, FRAME},
+    {"field fb", renderField, FRAME},
+    {"ticker fb", renderTicker, FRAME},
+    {"clear hash", renderClear, HASHED},
+    {"text 1X hash", renderText1X, HASHED},
+    {"field hash", renderField, HASHED},
+};
+
+// The same panel rendered with page addressing only.
+static const DevType MEM_TYPE Adafruit128x64Paged = {
+    Adafruit128x64init,
+    sizeof(Adafruit128x64init),
+    128,
+    64,
+    0,
+    0};
+
+static SSD1306Emulator::Controller controller(const DevType *dev)
+{
+    return dev == &SH1106_128x64 ? SSD1306Emulator::SH1106 : SSD1306Emulator::SSD1306;
+}
+
+// Render a few frames on the device of the case over I2C and over SPI and
+// on the paged panel, compare their pixels, and with the pixels of the
+// reference if the case has one.
+static bool samePixels(const BenchCase &c)
+{
+    const BenchCase ref = {c.name, c.reference ? c.reference : c.render, DIRECT, nullptr};
+    SSD1306Emulator fast(c.dev, controller(c.dev));
+    SSD1306Emulator spi(c.dev, controller(c.dev));
+    SSD1306Emulator paged(&Adafruit128x64Paged);
+    SSD1306Emulator plain(&Adafruit128x64Paged);
+    EmulatorI2CBus fastBus(fast);
+    EmulatorSpiBus spiBus(spi);
+    EmulatorI2CBus pagedBus(paged);
+    EmulatorI2CBus plainBus(plain);
+    BenchDisplay fastOled(fastBus);
+    BenchDisplay spiOled(spiBus);
+    BenchDisplay pagedOled(pagedBus);
+    BenchDisplay plainOled(plainBus);
+    fastOled.begin(c.dev, 0x3C);
+    spiOled.begin(c.dev, 0x3C);
+    pagedOled.begin(&Adafruit128x64Paged, 0x3C);
+    plainOled.begin(&Adafruit128x64Paged, 0x3C);
+    setMode(fastOled, c.mode);
+    setMode(spiOled, c.mode);
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        renderFrame(fastOled, c);
+        renderFrame(spiOled, c);
+        renderFrame(pagedOled, c);
+        renderFrame(plainOled, ref);
+        if (!fast.samePixels(paged) || !fast.samePixels(plain) || !spi.samePixels(plain))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// What one frame of a case costs on average.
+struct BenchCost
+{
+    double transfers;
+    double bytes;
+    double wire400k;
+    double wire1M;
+    double cpu;
+};
+
+static BenchCost measure(BenchDisplay &oled, MockI2CBus &bus, const BenchCase &c,
+                         uint32_t iterations)
+{
+    setMode(oled, c.mode);
+    oled.flush();
+    bus.reset();
+    uint64_t start = ssd1306_time_us();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        renderFrame(oled, c);
+    }
+    double cpu = (double)(ssd1306_time_us() - start) / iterations;
+    setMode(oled, DIRECT);
+    return {(double)bus.transferCount() / iterations, (double)bus.byteCount() / iterations,
+            bus.wireTimeUs(400000) / iterations, bus.wireTimeUs(1000000) / iterations, cpu};
+}
+
+// SPI wire time of one frame at 10 MHz, the SSD1306 maximum.
+static double spiTimeUs(const BenchCase &c, uint32_t iterations)
+{
+    SSD1306Emulator model(c.dev, controller(c.dev));
+    EmulatorSpiBus bus(model);
+    BenchDisplay oled(bus);
+    oled.begin(c.dev, 0x3C);
+    setMode(oled, c.mode);
+    oled.flush();
+    model.resetCounters();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        renderFrame(oled, c);
+    }
+    return model.spiTimeUs(10000000) / iterations;
+}
+
+// Each case runs on its device and on an SSD1306 panel with page addressing
+// only. The deltas are the address window's saving; a case that sends more
+// bytes with the window fails the bench.
+int main(int argc, char *argv[])
+{
+    const uint32_t iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    MockI2CBus bus(false);
+    BenchDisplay oled(bus);
+    MockI2CBus pagedBus(false);
+    BenchDisplay pagedOled(pagedBus);
+    pagedOled.begin(&Adafruit128x64Paged, 0x3C);
+    int rtn = 0;
+
+    printf("%-14s %10s %10s %8s %12s %10s %12s %12s %10s %8s\n", "case", "transfers",
+           "bytes", "d bytes", "wire@400k us", "d 400k us", "wire@1M us", "spi@10M us",
+           "cpu us", "pixels");
+    for (const BenchCase &c : cases)
+    {
+        oled.begin(c.dev, 0x3C);
+        BenchCost cost = measure(oled, bus, c, iterations);
+        BenchCost paged = measure(pagedOled, pagedBus, c, iterations);
+        double spi = spiTimeUs(c, iterations);
+        bool same = samePixels(c);
+        bool fewer = cost.bytes <= paged.bytes;
+        printf("%-14s %10.1f %10.1f %8.1f %12.1f %10.1f %12.1f %12.1f %10.2f %8s%s\n",
+               c.name, cost.transfers, cost.bytes, cost.bytes - paged.bytes, cost.wire400k,
+               cost.wire400k - paged.wire400k, cost.wire1M, spi, cost.cpu,
+               same ? "same" : "DIFF", fewer ? "" : " MORE");
+        if (!same || !fewer)
+        {
+            rtn = 1;
+        }
+    }
+    return rtn;
+}
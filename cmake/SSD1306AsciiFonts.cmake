@@ -0,0 +1,104 @@
+# Font headers generated at build time
+#
+# ssd1306_ascii_font_subset(<target> NAME <name> FONT <font>
+#                           [CHARS <characters>] [SOURCES <files>...]
+#                           [FORMAT glcd|sparse] [UTF8])
+#
+# Writes ssd1306_fonts/<name>.h to the binary directory with the characters
+# of CHARS and of the string literals in SOURCES, and adds the directory to
+# the include path of <target>. FONT is a bundled font such as Arial14 or the
+# path of a font header. UTF8 decodes the string literals as UTF-8.
+#
+# ssd1306_ascii_font_compile(<target> NAME <name> FONT <bdf or pcf>
+#                            [FORMAT paged|sparse|glcd] [SPACING <columns>]
+#                            [RANGES <first-last>...])
+#
+# Compiles a BDF or PCF bitmap font into ssd1306_fonts/<name>.h the same way.
+include_guard(GLOBAL)
+
+find_package(Python3 COMPONENTS Interpreter QUIET)
+
+set(SSD1306_ASCII_TOOLS_DIR "${CMAKE_CURRENT_LIST_DIR}/../tools")
+if(EXISTS "${CMAKE_CURRENT_LIST_DIR}/../include/ssd1306_ascii_pico/fonts")
+  set(SSD1306_ASCII_FONTS_DIR "${CMAKE_CURRENT_LIST_DIR}/../include/ssd1306_ascii_pico/fonts")
+else()
+  # Installed in share/ssd1306_ascii_pico/cmake
+  set(SSD1306_ASCII_FONTS_DIR "${CMAKE_CURRENT_LIST_DIR}/../../../include/ssd1306_ascii_pico/fonts")
+endif()
+
+function(ssd1306_ascii_font_subset target)
+  cmake_parse_arguments(ARG "UTF8" "FONT;NAME;CHARS;FORMAT" "SOURCES" ${ARGN})
+  if(NOT ARG_NAME OR NOT ARG_FONT)
+    message(FATAL_ERROR "ssd1306_ascii_font_subset: NAME and FONT are required")
+  endif()
+  if(NOT Python3_Interpreter_FOUND)
+    message(FATAL_ERROR "ssd1306_ascii_font_subset: Python 3 is required")
+  endif()
+  if(NOT ARG_FORMAT)
+    set(ARG_FORMAT glcd)
+  endif()
+
+  if(EXISTS "${SSD1306_ASCII_FONTS_DIR}/${ARG_FONT}.h")
+    set(font "${SSD1306_ASCII_FONTS_DIR}/${ARG_FONT}.h")
+  else()
+    get_filename_component(font "${ARG_FONT}" ABSOLUTE)
+  endif()
+
+  set(args --name ${ARG_NAME} --format ${ARG_FORMAT})
+  if(DEFINED ARG_CHARS)
+    list(APPEND args "--chars=${ARG_CHARS}")
+  endif()
+  set(sources)
+  foreach(source IN LISTS ARG_SOURCES)
+    get_filename_component(source "${source}" ABSOLUTE)
+    list(APPEND sources "${source}")
+    list(APPEND args --source "${source}")
+  endforeach()
+  if(ARG_UTF8)
+    list(APPEND args --utf8)
+  endif()
+
+  _ssd1306_ascii_font_header(${target} ${ARG_NAME} font_subset.py "${font}"
+                             "${sources}" ${args})
+endfunction()
+
+function(ssd1306_ascii_font_compile target)
+  cmake_parse_arguments(ARG "" "FONT;NAME;FORMAT;SPACING" "RANGES" ${ARGN})
+  if(NOT ARG_NAME OR NOT ARG_FONT)
+    message(FATAL_ERROR "ssd1306_ascii_font_compile: NAME and FONT are required")
+  endif()
+  if(NOT Python3_Interpreter_FOUND)
+    message(FATAL_ERROR "ssd1306_ascii_font_compile: Python 3 is required")
+  endif()
+  if(NOT ARG_FORMAT)
+    set(ARG_FORMAT paged)
+  endif()
+  if(NOT ARG_SPACING)
+    set(ARG_SPACING 0)
+  endif()
+
+  get_filename_component(font "${ARG_FONT}" ABSOLUTE)
+  set(args --name ${ARG_NAME} --format ${ARG_FORMAT} --spacing ${ARG_SPACING})
+  foreach(range IN LISTS ARG_RANGES)
+    list(APPEND args --range ${range})
+  endforeach()
+  _ssd1306_ascii_font_header(${target} ${ARG_NAME} bdf_compile.py "${font}" "" ${args})
+endfunction()
+
+# Run a font tool writing ssd1306_fonts/<name>.h and add it to <target>
+function(_ssd1306_ascii_font_header target name tool font depends)
+  set(dir "${CMAKE_CURRENT_BINARY_DIR}/ssd1306_fonts")
+  set(output "${dir}/${name}.h")
+  add_custom_command(
+    OUTPUT "${output}"
+    COMMAND ${CMAKE_COMMAND} -E make_directory "${dir}"
+    COMMAND Python3::Interpreter "${SSD1306_ASCII_TOOLS_DIR}/${tool}"
+            "${font}" -o "${output}" ${ARGN}
+    DEPENDS "${font}" ${depends}
+            "${SSD1306_ASCII_TOOLS_DIR}/${tool}"
+            "${SSD1306_ASCII_TOOLS_DIR}/ssd1306_font.py"
+    COMMENT "Generating font ${name}"
+    VERBATIM)
+  target_sources(${target} PRIVATE "${output}")
+  target_include_directories(${target} PRIVATE "${CMAKE_CURRENT_BINARY_DIR}")
+endfunction()
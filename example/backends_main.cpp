@@ -0,0 +1,64 @@
+// Pin map, one set of pins per bus:
+//
+// | Bus         | Pins                                  |
+// | ----------- | ------------------------------------- |
+// | I2CDmaBus   | I2C0 SDA GPIO 4, SCL GPIO 5           |
+// | SPIBus      | SPI0 SCK GPIO 2, MOSI GPIO 3          |
+// |             | CS GPIO 7, D/C GPIO 8                 |
+// | PioI2CBus   | PIO0 SDA GPIO 10, SCL GPIO 11         |
+// | I2CAsyncBus | I2C1 SDA GPIO 14, SCL GPIO 15         |
+
+#include <ssd1306_ascii_pico/ssd1306_ascii_i2c_async.h>
+#include <ssd1306_ascii_pico/ssd1306_ascii_i2c_dma.h>
+#include <ssd1306_ascii_pico/ssd1306_ascii_pio_i2c.h>
+#include <ssd1306_ascii_pico/ssd1306_ascii_spi.h>
+#include <ssd1306_ascii_pico/ssd1306_ascii_worker.h>
+
+// Build every bus of the library against the Pico SDK.
+static void showBus(SSD1306Ascii &display, const char *name)
+{
+    display.setFont(Adafruit5x7);
+    display.clear();
+    display.print(name);
+    display.flush();
+}
+
+int main()
+{
+    I2CDmaBus dmaBus = I2CDmaBus(0, 4, 5, 400000L);
+    SSD1306AsciiI2C dmaDisplay = SSD1306AsciiI2C(dmaBus);
+    dmaDisplay.begin(&Adafruit128x64, 0x3C);
+    showBus(dmaDisplay, "I2CDmaBus");
+    dmaBus.wait();
+
+    SPIBus spiBus = SPIBus(0, 2, 3, 10000000L);
+    SSD1306AsciiSpi spiDisplay = SSD1306AsciiSpi(spiBus);
+    spiDisplay.begin(&Adafruit128x64, 7, 8);
+    showBus(spiDisplay, "SPIBus");
+
+    PioI2CBus pioBus = PioI2CBus(pio0, 10, 11, 1000000L);
+    SSD1306AsciiI2C pioDisplay = SSD1306AsciiI2C(pioBus);
+    pioDisplay.begin(&Adafruit128x64, 0x3C);
+    showBus(pioDisplay, "PioI2CBus");
+    pioBus.wait();
+
+    I2CAsyncBus asyncBus = I2CAsyncBus(1, 14, 15, 400000L);
+    SSD1306AsciiI2C asyncDisplay = SSD1306AsciiI2C(asyncBus);
+    asyncDisplay.begin(&Adafruit128x64, 0x3C);
+    showBus(asyncDisplay, "I2CAsyncBus");
+
+    // Core 1 renders on the asynchronous bus.
+    static const Font paged = pagedFont<Arial14>;
+    SSD1306AsciiWorker worker = SSD1306AsciiWorker(asyncDisplay);
+    worker.start();
+    worker.setFont(&paged);
+    worker.setMag(1, 1);
+    worker.setUtf8Mode(true);
+    worker.print(0, 2, "SSD1306AsciiWorker");
+    while (worker.queueDepth())
+    {
+        tight_loop_contents();
+    }
+
+    return dmaBus.abortCount() + pioBus.abortCount() + asyncBus.abortCount() != 0;
+}
@@ -141,7 +141,7 @@ class Print
             return 0;
         return write((const uint8_t *)str, strlen(str));
     }
-    size_t write(const uint8_t *buffer, size_t size)
+    virtual size_t write(const uint8_t *buffer, size_t size)
     {
         size_t n = 0;
         while (size--)
@@ -30,7 +30,9 @@
 #include "Print.h"
 #include "SSD1306init.h"
 #include "fonts/allFonts.h"
-#include <pico/stdlib.h>
+#include "ssd1306_ascii_font.h"
+#include "ssd1306_ascii_font_transform.h"
+#include "ssd1306_ascii_hal.h"
 //------------------------------------------------------------------------------
 /** SSD1306Ascii version */
 #define SDD1306_ASCII_VERSION 1.3.0
@@ -56,6 +58,67 @@
 /** Use larger faster I2C code. */
 #define OPTIMIZE_I2C 1
 
+/** Size of the I2C transmit buffer in bytes.
+ *
+ * Bytes written between I2CBus::beginTransmission() and
+ * I2CBus::endTransmission() are sent as a single I2C transfer.
+ * With OPTIMIZE_I2C one byte of each transfer is used by the control
+ * byte so up to I2C_BUFFER_SIZE - 1 display RAM bytes are sent at once.
+ */
+#ifndef I2C_BUFFER_SIZE
+#define I2C_BUFFER_SIZE 32
+#endif // I2C_BUFFER_SIZE
+
+/** Number of entries in the I2CAsyncBus queue, must be a power of two. */
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE 256
+#endif // I2C_QUEUE_SIZE
+
+/** Number of operations in the SSD1306AsciiWorker ring, a power of two. */
+#ifndef WORKER_QUEUE_DIM
+#define WORKER_QUEUE_DIM 16
+#endif // WORKER_QUEUE_DIM
+
+/** Text bytes carried by one SSD1306AsciiWorker operation. */
+#ifndef WORKER_TEXT_DIM
+#define WORKER_TEXT_DIM 24
+#endif // WORKER_TEXT_DIM
+
+/** Size of each of the two SPI transmit buffers in bytes. */
+#ifndef SPI_BUFFER_SIZE
+#define SPI_BUFFER_SIZE 128
+#endif // SPI_BUFFER_SIZE
+
+/** Shortest SPI transfer sent by DMA. Shorter ones are written by the CPU. */
+#ifndef SPI_DMA_MIN
+#define SPI_DMA_MIN 8
+#endif // SPI_DMA_MIN
+
+/** Columns covered by each hash of setSegmentHashes(). */
+#ifndef SEGMENT_HASH_COLS
+#define SEGMENT_HASH_COLS 16
+#endif // SEGMENT_HASH_COLS
+
+/** Characters of a string rendered together by write(buffer, size). */
+#ifndef GLYPH_RUN_SIZE
+#define GLYPH_RUN_SIZE 32
+#endif // GLYPH_RUN_SIZE
+
+/** Fonts held by a FontArena. */
+#ifndef FONT_ARENA_FONTS
+#define FONT_ARENA_FONTS 4
+#endif // FONT_ARENA_FONTS
+
+/** Fonts in a FontChain. */
+#ifndef FONT_CHAIN_FONTS
+#define FONT_CHAIN_FONTS 4
+#endif // FONT_CHAIN_FONTS
+
+/** Characters a FontChain remembers the font of, a power of two. */
+#ifndef FONT_CHAIN_CACHE
+#define FONT_CHAIN_CACHE 16
+#endif // FONT_CHAIN_CACHE
+
 //------------------------------------------------------------------------------
 // Values for setScrolMode(uint8_t mode)
 /** Newline will not scroll the display or RAM window. */
@@ -72,6 +135,8 @@
 #define SSD1306_MODE_RAM 1
 /** Write to display RAM with possible buffering. */
 #define SSD1306_MODE_RAM_BUF 2
+/** Write to Command register with possible buffering. */
+#define SSD1306_MODE_CMD_BUF 3
 //------------------------------------------------------------------------------
 /**
  * @brief Reset the display controller.
@@ -80,16 +145,473 @@
  */
 inline void oledReset(uint8_t rst)
 {
-    gpio_init(rst);
-    gpio_set_dir(rst, true);
-    gpio_put(rst, 0);
-    sleep_ms(10);
-    gpio_put(rst, 1);
-    sleep_ms(10);
+    ssd1306_gpio_init_out(rst);
+    ssd1306_gpio_put(rst, 0);
+    ssd1306_sleep_ms(10);
+    ssd1306_gpio_put(rst, 1);
+    ssd1306_sleep_ms(10);
 }
 //------------------------------------------------------------------------------
-GLCDFONTDECL(scaledNibble) = {0X00, 0X03, 0X0C, 0X0F, 0X30, 0X33, 0X3C, 0X3F,
-                              0XC0, 0XC3, 0XCC, 0XCF, 0XF0, 0XF3, 0XFC, 0XFF};
+/**
+ * @struct Utf8Decoder
+ * @brief Streaming UTF-8 decoder.
+ */
+struct Utf8Decoder
+{
+    uint32_t cp = 0;  ///< Bits of the character being decoded.
+    uint8_t need = 0; ///< Continuation bytes still expected.
+    uint8_t size = 0; ///< Continuation bytes of the sequence.
+    /**
+     * @brief Decode the next byte of UTF-8 text.
+     *
+     * Invalid bytes, overlong encodings, surrogates and characters above
+     * U+FFFF decode as U+FFFD.  A byte that cuts a sequence short ends it
+     * with U+FFFD, so an ASCII byte may complete two characters.
+     *
+     * @param[in] b The next byte.
+     * @param[out] c The decoded characters, room for two.
+     * @return Number of characters in c, zero if more bytes are needed.
+     */
+    uint8_t decode(uint8_t b, uint16_t c[2])
+    {
+        uint8_t n = 0;
+        if (need && (b & 0XC0) != 0X80)
+        {
+            need = 0;
+            c[n++] = 0XFFFD;
+        }
+        if (b < 0X80)
+        {
+            c[n++] = b;
+            return n;
+        }
+        if (b < 0XC0)
+        {
+            if (!need)
+            {
+                c[n++] = 0XFFFD;
+                return n;
+            }
+            cp = (cp << 6) | (b & 0X3F);
+            if (--need)
+            {
+                return 0;
+            }
+            // Four byte sequences are all above U+FFFF or overlong.
+            uint32_t min = size == 1 ? 0X80 : 0X800;
+            bool bad = cp < min || cp > 0XFFFF || (cp >= 0XD800 && cp <= 0XDFFF);
+            c[n++] = bad ? 0XFFFD : cp;
+            return n;
+        }
+        if (b < 0XC2 || b > 0XF4)
+        {
+            c[n++] = 0XFFFD;
+            return n;
+        }
+        need = size = b < 0XE0 ? 1 : b < 0XF0 ? 2 : 3;
+        cp = b & (0X3F >> need);
+        return n;
+    }
+    /**
+     * @brief End the text.
+     *
+     * @param[out] c U+FFFD if the text ends inside a sequence.
+     * @return Number of characters in c.
+     */
+    uint8_t finish(uint16_t *c)
+    {
+        if (!need)
+        {
+            return 0;
+        }
+        need = 0;
+        *c = 0XFFFD;
+        return 1;
+    }
+};
+//------------------------------------------------------------------------------
+/**
+ * @class FontArena
+ * @brief RAM copies of font tables.
+ *
+ * Font reads from XIP flash stall on misses of the XIP cache, which code
+ * running from flash shares.  A font copied into RAM renders in the same
+ * time on every frame.  Fonts are copied in order until the arena or its
+ * FONT_ARENA_FONTS slots are used up, later fonts stay in flash.
+ */
+class FontArena
+{
+  public:
+    /**
+     * @param[in] buf RAM for font tables.
+     * @param[in] size Size of buf.
+     */
+    FontArena(uint8_t *buf, size_t size) : m_buf(buf), m_size(size)
+    {
+    }
+    /**
+     * @brief Find or make the RAM copy of a font.
+     *
+     * The table and the glyph offsets of a GLCD font are copied.
+     *
+     * @param[in] font The font.
+     * @return The RAM copy, or font if it does not fit.
+     */
+    Font load(const Font &font)
+    {
+        const uint8_t *table = font.table();
+        if (!table || (table >= m_buf && table < m_buf + m_size))
+        {
+            return font;
+        }
+        for (uint8_t i = 0; i < m_nFonts; i++)
+        {
+            if (m_fonts[i].table == table && m_fonts[i].index == font.glyphOffsets())
+            {
+                return m_fonts[i].copy;
+            }
+        }
+        if (m_nFonts == FONT_ARENA_FONTS)
+        {
+            return font;
+        }
+        size_t size = font.tableSize();
+        size_t at = m_used + size;
+        size_t indexSize = 0;
+        if (font.glyphOffsets())
+        {
+            at += (uintptr_t)(m_buf + at) & 1;
+            indexSize = 2 * font.count();
+        }
+        if (at + indexSize > m_size)
+        {
+            return font;
+        }
+        memcpy(m_buf + m_used, table, size);
+        uint16_t *index = nullptr;
+        if (indexSize)
+        {
+            index = (uint16_t *)(m_buf + at);
+            memcpy(index, font.glyphOffsets(), indexSize);
+        }
+        Entry &e = m_fonts[m_nFonts++];
+        e.table = table;
+        e.index = font.glyphOffsets();
+        e.copy = Font(m_buf + m_used, index);
+        m_used = at + indexSize;
+        return e.copy;
+    }
+    /**
+     * @param[in] table Pointer to a font table.
+     * @return true if the font has a RAM copy.
+     */
+    bool contains(const uint8_t *table) const
+    {
+        for (uint8_t i = 0; i < m_nFonts; i++)
+        {
+            if (m_fonts[i].table == table)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    /**
+     * @brief Drop all copies.  Fonts set from the arena must be set again.
+     */
+    void reset()
+    {
+        m_nFonts = 0;
+        m_used = 0;
+    }
+    /**
+     * @return Bytes of the arena in use.
+     */
+    size_t used() const
+    {
+        return m_used;
+    }
+    /**
+     * @return Size of the arena.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+  private:
+    struct Entry
+    {
+        const uint8_t *table;  // Font table in flash.
+        const uint16_t *index; // Glyph offsets in flash.
+        Font copy;             // The font in RAM.
+    };
+    uint8_t *m_buf;
+    size_t m_size;
+    size_t m_used = 0;
+    uint8_t m_nFonts = 0;
+    Entry m_fonts[FONT_ARENA_FONTS];
+};
+//------------------------------------------------------------------------------
+/**
+ * @class GlyphCacheStore
+ * @brief Characters as sent to display RAM, see GlyphCache.
+ *
+ * Entries are found by font, character, magnification and invert mode and
+ * replaced least recently used first.  Each entry holds up to slotSize()
+ * bytes, larger characters are rendered from the font.
+ */
+class GlyphCacheStore
+{
+  public:
+    GlyphCacheStore(const GlyphCacheStore &) = delete;
+    GlyphCacheStore &operator=(const GlyphCacheStore &) = delete;
+    /**
+     * @brief Drop all characters, e.g. after FontArena::reset().
+     */
+    void clear()
+    {
+        for (uint8_t i = 0; i < m_n; i++)
+        {
+            m_entries[i].font = nullptr;
+            m_entries[i].used = 0;
+        }
+    }
+    /**
+     * @brief Find a character and keep it for the current run.
+     *
+     * @param[in] font Font table.
+     * @param[in] glyph Character index in the font.
+     * @param[in] mag Magnification, horizontal factor in the high nibble.
+     * @param[in] invert Invert mask.
+     * @return The cached bytes, nullptr on a miss.
+     */
+    const uint8_t *find(const uint8_t *font, uint16_t glyph, uint8_t mag, uint8_t invert)
+    {
+        for (uint8_t i = 0; i < m_n; i++)
+        {
+            Entry &e = m_entries[i];
+            if (e.font == font && e.glyph == glyph && e.mag == mag && e.invert == invert)
+            {
+                e.used = m_clock;
+                m_hits++;
+                return m_data + i * m_slotSize;
+            }
+        }
+        m_misses++;
+        return nullptr;
+    }
+    /**
+     * @brief Replace the least recently used character not in the run.
+     *
+     * @return Storage for slotSize() bytes, nullptr if every entry is in
+     *         the current run.
+     */
+    uint8_t *insert(const uint8_t *font, uint16_t glyph, uint8_t mag, uint8_t invert)
+    {
+        Entry *lru = nullptr;
+        for (uint8_t i = 0; i < m_n; i++)
+        {
+            Entry &e = m_entries[i];
+            if (e.used != m_clock && (!lru || e.used < lru->used))
+            {
+                lru = &e;
+            }
+        }
+        if (!lru)
+        {
+            return nullptr;
+        }
+        lru->font = font;
+        lru->glyph = glyph;
+        lru->mag = mag;
+        lru->invert = invert;
+        lru->used = m_clock;
+        return m_data + (lru - m_entries) * m_slotSize;
+    }
+    /**
+     * @brief Start a run, characters found or inserted are kept until the
+     *        next run.
+     */
+    void beginRun()
+    {
+        m_clock++;
+    }
+    /**
+     * @return Bytes of each entry.
+     */
+    uint16_t slotSize() const
+    {
+        return m_slotSize;
+    }
+    /**
+     * @return Characters found in the cache.
+     */
+    uint32_t hits() const
+    {
+        return m_hits;
+    }
+    /**
+     * @return Characters rendered from the font.
+     */
+    uint32_t misses() const
+    {
+        return m_misses;
+    }
+    /**
+     * @brief Zero the hit and miss counters.
+     */
+    void resetStats()
+    {
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+  protected:
+    struct Entry
+    {
+        const uint8_t *font; // Font table, nullptr if unused.
+        uint16_t glyph;      // Character index.
+        uint8_t mag;         // Horizontal and vertical factor.
+        uint8_t invert;      // Invert mask.
+        uint32_t used;       // Run of the last use.
+    };
+    GlyphCacheStore(Entry *entries, uint8_t *data, uint8_t n, uint16_t slotSize)
+        : m_entries(entries), m_data(data), m_n(n), m_slotSize(slotSize)
+    {
+        clear();
+    }
+
+  private:
+    Entry *m_entries;
+    uint8_t *m_data;
+    uint8_t m_n;
+    uint16_t m_slotSize;
+    uint32_t m_clock = 1;
+    uint32_t m_hits = 0;
+    uint32_t m_misses = 0;
+};
+/**
+ * @class GlyphCache
+ * @brief A GlyphCacheStore with its storage.
+ *
+ * @tparam Entries Number of characters.
+ * @tparam Bytes Total storage, split evenly between the entries.  An entry
+ *         holds rows() * magY * magX * width bytes of a character.
+ */
+template <uint8_t Entries, uint16_t Bytes>
+class GlyphCache : public GlyphCacheStore
+{
+    static_assert(Entries > 0 && Bytes >= Entries, "GlyphCache is too small");
+
+  public:
+    GlyphCache() : GlyphCacheStore(m_entries, m_data, Entries, Bytes / Entries)
+    {
+    }
+
+  private:
+    Entry m_entries[Entries];
+    uint8_t m_data[Bytes];
+};
+//------------------------------------------------------------------------------
+/**
+ * @class FontChain
+ * @brief Fonts searched in order for each character, see setFontChain().
+ *
+ * The font of recently displayed characters is kept in a table of
+ * FONT_CHAIN_CACHE entries indexed by the low bits of the character code.
+ */
+class FontChain
+{
+    static_assert((FONT_CHAIN_CACHE & (FONT_CHAIN_CACHE - 1)) == 0,
+                  "FONT_CHAIN_CACHE must be a power of two");
+
+  public:
+    /**
+     * @param[in] fonts Fonts or font tables, e.g. FontChain(Verdana12,
+     *            utf8font10x16), at most FONT_CHAIN_FONTS.
+     */
+    template <typename... Fonts>
+    explicit FontChain(const Fonts &...fonts) : m_fonts{Font(fonts)...}, m_nFonts(sizeof...(Fonts))
+    {
+        static_assert(sizeof...(Fonts) > 0 && sizeof...(Fonts) <= FONT_CHAIN_FONTS,
+                      "FontChain holds one to FONT_CHAIN_FONTS fonts");
+        for (uint8_t k = 0; k < m_nFonts; k++)
+        {
+            if (m_fonts[k].rows() > m_rows)
+            {
+                m_rows = m_fonts[k].rows();
+            }
+        }
+        for (uint16_t i = 0; i < FONT_CHAIN_CACHE; i++)
+        {
+            m_cache[i].font = UNRESOLVED;
+        }
+    }
+    /**
+     * @brief Find the first font with a character.
+     *
+     * @param[in] c Character code.
+     * @param[out] glyph Index of the character in the font.
+     * @return Font number, -1 if no font has the character.
+     */
+    int8_t resolve(uint16_t c, uint16_t *glyph)
+    {
+        Entry &e = m_cache[c & (FONT_CHAIN_CACHE - 1)];
+        if (e.font == UNRESOLVED || e.c != c)
+        {
+            e.c = c;
+            e.font = -1;
+            for (uint8_t k = 0; k < m_nFonts; k++)
+            {
+                int32_t g = m_fonts[k].index(c);
+                if (g >= 0)
+                {
+                    e.font = k;
+                    e.glyph = g;
+                    break;
+                }
+            }
+        }
+        *glyph = e.glyph;
+        return e.font;
+    }
+    /**
+     * @param[in] k Font number.
+     * @return Font k of the chain.
+     */
+    const Font &font(uint8_t k) const
+    {
+        return m_fonts[k];
+    }
+    /**
+     * @return Number of fonts in the chain.
+     */
+    uint8_t fonts() const
+    {
+        return m_nFonts;
+    }
+    /**
+     * @return Rows of the tallest font.
+     */
+    uint8_t rows() const
+    {
+        return m_rows;
+    }
+
+  private:
+    static const int8_t UNRESOLVED = -2;
+    struct Entry
+    {
+        uint16_t c;     // Character code.
+        uint16_t glyph; // Index in the font.
+        int8_t font;    // Font number, -1 if missing.
+    };
+    Font m_fonts[FONT_CHAIN_FONTS];
+    uint8_t m_nFonts;
+    uint8_t m_rows = 0;
+    Entry m_cache[FONT_CHAIN_CACHE];
+};
 //------------------------------------------------------------------------------
 /**
  * @struct TickerState
@@ -214,7 +736,11 @@ class SSD1306Ascii : public Print
     void setStartLine(uint8_t line)
     {
         m_startLine = line & 0X3F;
-        ssd1306WriteCmd(SSD1306_SETSTARTLINE | m_startLine);
+        // A render() pass only records the line, render() sends it once.
+        if (!(m_hashes && m_frameBuffer))
+        {
+            ssd1306WriteCmd(SSD1306_SETSTARTLINE | m_startLine);
+        }
     }
     /**
      * @return the display startline.
@@ -231,7 +757,7 @@ class SSD1306Ascii : public Print
      * @param[in] c Character code.
      * @return Spacing of the character in pixels.
      */
-    uint8_t charSpacing(uint8_t c)
+    uint8_t charSpacing(uint16_t c)
     {
         return charWidth(c) + letterSpacing();
     }
@@ -241,25 +767,11 @@ class SSD1306Ascii : public Print
      * @param[in] c Character code.
      * @return Width of the character in pixels.
      */
-    uint8_t charWidth(uint8_t c) const
+    uint8_t charWidth(uint16_t c) const
     {
-        if (!m_font)
-        {
-            return 0;
-        }
-        uint8_t first = readFontByte(m_font + FONT_FIRST_CHAR);
-        uint8_t count = readFontByte(m_font + FONT_CHAR_COUNT);
-        if (c < first || c >= (first + count))
-        {
-            return 0;
-        }
-        if (fontSize() > 1)
-        {
-            // Proportional font.
-            return m_magFactor * readFontByte(m_font + FONT_WIDTH_TABLE + c - first);
-        }
-        // Fixed width font.
-        return m_magFactor * readFontByte(m_font + FONT_WIDTH);
+        uint16_t glyph;
+        int8_t k = m_font ? findGlyph(c, &glyph) : -1;
+        return k < 0 ? 0 : m_magX * runFont(k).glyphWidth(glyph);
     }
     /**
      * @brief Clear the display and set the cursor to (0, 0).
@@ -268,7 +780,10 @@ class SSD1306Ascii : public Print
     {
 #if INCLUDE_SCROLLING
         m_pageOffset = 0;
-        setStartLine(0);
+        if (m_startLine)
+        {
+            setStartLine(0);
+        }
 #endif // INCLUDE_SCROLLING
         clear(0, displayWidth() - 1, 0, displayRows() - 1);
     }
@@ -286,17 +801,31 @@ class SSD1306Ascii : public Print
         // Cancel skip character pixels.
         m_skip = 0;
 
-        // Insure only rows on display will be cleared.
+        // Insure only rows and columns on display will be cleared.
         if (r1 >= displayRows())
             r1 = displayRows() - 1;
+        if (c1 >= displayWidth())
+            c1 = displayWidth() - 1;
 
-        for (uint8_t r = r0; r <= r1; r++)
+        // Two pages cost the same with or without a window.
+        if (r1 > r0 + 1 && setWindow(c0, c1, r0, r1))
+        {
+            // One data stream fills the whole window.
+            for (uint16_t n = (c1 - c0 + 1) * (r1 - r0 + 1); n; n--)
+            {
+                writeDisplay(0, SSD1306_MODE_RAM_BUF);
+            }
+        }
+        else
         {
-            setCursor(c0, r);
-            for (uint8_t c = c0; c <= c1; c++)
+            for (uint8_t r = r0; r <= r1; r++)
             {
-                // Insure clear() writes zero. result is (m_invertMask^m_invertMask).
-                ssd1306WriteRamBuf(m_invertMask);
+                setCursor(c0, r);
+                for (uint8_t c = c0; c <= c1; c++)
+                {
+                    // Insure clear() writes zero. result is (m_invertMask^m_invertMask).
+                    ssd1306WriteRamBuf(m_invertMask);
+                }
             }
         }
         setCursor(c0, r0);
@@ -332,6 +861,16 @@ class SSD1306Ascii : public Print
     {
         return m_col;
     }
+    /**
+     * @brief Send the changed spans of the frame buffer to the controller
+     *        and wait until the bus has sent them.
+     *
+     * Same as flush(), see setFrameBuffer().
+     */
+    void display()
+    {
+        flush();
+    }
     /**
      * @return The display hight in pixels.
      */
@@ -382,28 +921,35 @@ class SSD1306Ascii : public Print
      */
     const uint8_t *font() const
     {
-        return m_font;
+        return m_font.table();
     }
     /**
      * @return The count of characters in a font.
      */
-    uint8_t fontCharCount() const
+    uint16_t fontCharCount() const
     {
-        return m_font ? readFontByte(m_font + FONT_CHAR_COUNT) : 0;
+        return m_font.count();
     }
     /**
      * @return The first character in a font.
      */
     char fontFirstChar() const
     {
-        return m_font ? readFontByte(m_font + FONT_FIRST_CHAR) : 0;
+        return m_font.first();
+    }
+    /**
+     * @return The current font.
+     */
+    const Font &fontHandle() const
+    {
+        return m_font;
     }
     /**
      * @return The current font height in pixels.
      */
     uint8_t fontHeight() const
     {
-        return m_font ? m_magFactor * readFontByte(m_font + FONT_HEIGHT) : 0;
+        return m_magY * m_font.height();
     }
     /**
      * @return The number of eight pixel rows required to display a character
@@ -411,14 +957,14 @@ class SSD1306Ascii : public Print
      */
     uint8_t fontRows() const
     {
-        return m_font ? m_magFactor * ((readFontByte(m_font + FONT_HEIGHT) + 7) / 8) : 0;
+        return m_magY * m_font.rows();
     }
     /**
      * @return The maximum width of characters in the current font.
      */
     uint8_t fontWidth() const
     {
-        return m_font ? m_magFactor * readFontByte(m_font + FONT_WIDTH) : 0;
+        return m_magX * m_font.width();
     }
     /**
      * @brief Set the cursor position to (0, 0).
@@ -445,10 +991,16 @@ class SSD1306Ascii : public Print
         m_displayWidth = readFontByte(&dev->lcdWidth);
         m_displayHeight = readFontByte(&dev->lcdHeight);
         m_colOffset = readFontByte(&dev->colOffset);
+        m_addrWindow = readFontByte(&dev->addrWindow);
+        // Addressing mode is unknown until page mode is set.
+        m_pageMode = !m_addrWindow;
         for (uint8_t i = 0; i < size; i++)
         {
-            ssd1306WriteCmd(readFontByte(table + i));
+            ssd1306WriteCmdBuf(readFontByte(table + i));
         }
+#if INCLUDE_SCROLLING
+        setStartLine(0);
+#endif // INCLUDE_SCROLLING
         clear();
     }
     /**
@@ -477,23 +1029,59 @@ class SSD1306Ascii : public Print
         m_invertMask = mode ? 0XFF : 0;
     }
     /**
-     * @return letter-spacing in pixels with magnification factor.
+     * @return UTF-8 mode.
      */
-    uint8_t letterSpacing() const
+    bool utf8Mode() const
     {
-        return m_magFactor * m_letterSpacing;
+        return m_utf8Mode;
     }
     /**
-     * @return The character magnification factor.
+     * @brief Set UTF-8 mode for write/print.
+     *
+     * In UTF-8 mode multi-byte sequences are decoded to a single character,
+     * so fonts such as utf8font10x16 display U+0080 to U+00FF.  A sequence
+     * may be split across calls to write().  Malformed text is shown as '?'
+     * in fonts without U+FFFD.
+     *
+     * @param[in] mode Decode UTF-8 if true, one byte per character if false.
      */
-    uint8_t magFactor() const
+    void setUtf8Mode(bool mode)
     {
-        return m_magFactor;
+        m_utf8Mode = mode;
+        m_utf8 = Utf8Decoder();
     }
     /**
-     * @return the current row number with eight pixels to a row.
+     * @return letter-spacing in pixels with magnification factor.
      */
-    uint8_t row() const
+    uint8_t letterSpacing() const
+    {
+        return m_magX * m_letterSpacing;
+    }
+    /**
+     * @return The horizontal character magnification factor.
+     */
+    uint8_t magFactor() const
+    {
+        return m_magX;
+    }
+    /**
+     * @return The horizontal character magnification factor.
+     */
+    uint8_t magX() const
+    {
+        return m_magX;
+    }
+    /**
+     * @return The vertical character magnification factor.
+     */
+    uint8_t magY() const
+    {
+        return m_magY;
+    }
+    /**
+     * @return the current row number with eight pixels to a row.
+     */
+    uint8_t row() const
     {
         return m_row;
     }
@@ -502,14 +1090,34 @@ class SSD1306Ascii : public Print
      */
     void set1X()
     {
-        m_magFactor = 1;
+        setMag(1, 1);
     }
     /**
      * @brief Set the character magnification factor to two.
      */
     void set2X()
     {
-        m_magFactor = 2;
+        setMag(2, 2);
+    }
+    /**
+     * @brief Set the character magnification factor.
+     *
+     * @param[in] n Factor for both directions, one to MAG_MAX.
+     */
+    void setMag(uint8_t n)
+    {
+        setMag(n, n);
+    }
+    /**
+     * @brief Set separate horizontal and vertical magnification factors.
+     *
+     * @param[in] x Horizontal factor, one to MAG_MAX.
+     * @param[in] y Vertical factor, one to MAG_MAX.
+     */
+    void setMag(uint8_t x, uint8_t y)
+    {
+        m_magX = x < 1 ? 1 : x > MAG_MAX ? MAG_MAX : x;
+        m_magY = y < 1 ? 1 : y > MAG_MAX ? MAG_MAX : y;
     }
     /**
      * @brief Set the current column number.
@@ -521,9 +1129,14 @@ class SSD1306Ascii : public Print
         if (col < m_displayWidth)
         {
             m_col = col;
+            if (m_frameBuffer)
+            {
+                return;
+            }
             col += m_colOffset;
-            ssd1306WriteCmd(SSD1306_SETLOWCOLUMN | (col & 0XF));
-            ssd1306WriteCmd(SSD1306_SETHIGHCOLUMN | (col >> 4));
+            setPageMode();
+            ssd1306WriteCmdBuf(SSD1306_SETLOWCOLUMN | (col & 0XF));
+            ssd1306WriteCmdBuf(SSD1306_SETHIGHCOLUMN | (col >> 4));
         }
     }
     /**
@@ -547,6 +1160,64 @@ class SSD1306Ascii : public Print
         setCol(col);
         setRow(row);
     }
+    /**
+     * @brief Set the current font.
+     *
+     * @param[in] font A font handle or a pointer to a font table.
+     */
+    void setFont(const Font &font)
+    {
+        m_font = m_fontArena ? m_fontArena->load(font) : font;
+        m_fontChain = nullptr;
+        m_letterSpacing = font.spacing();
+    }
+    /**
+     * @brief Set a chain of fonts.
+     *
+     * Each character is displayed with the first font of the chain that
+     * has it.  The first font is the current font and sets the default
+     * letter-spacing.  setFont() ends the chain.
+     *
+     * @param[in] chain The fonts, nullptr to keep only the first font.
+     */
+    void setFontChain(FontChain *chain)
+    {
+        if (chain)
+        {
+            setFont(chain->font(0));
+        }
+        m_fontChain = chain;
+    }
+    /**
+     * @brief Copy fonts into RAM when they are set.
+     *
+     * setFont() renders from the arena's copy of a font, or from flash when
+     * the font does not fit.  The current font is loaded now.
+     *
+     * @param[in] arena The font arena, nullptr to stop copying fonts.
+     * @note A font set from the arena stays in use after the arena is
+     *       removed, until the next setFont().
+     */
+    void setFontArena(FontArena *arena)
+    {
+        m_fontArena = arena;
+        if (arena)
+        {
+            m_font = arena->load(m_font);
+        }
+    }
+    /**
+     * @brief Keep characters as sent to display RAM for repeated text.
+     *
+     * write() renders a character from the font once for each
+     * magnification and invert mode and sends the cached bytes after that.
+     *
+     * @param[in] cache A GlyphCache, nullptr to render every character.
+     */
+    void setGlyphCache(GlyphCacheStore *cache)
+    {
+        m_glyphCache = cache;
+    }
     /**
      * @brief Set the current font.
      *
@@ -554,15 +1225,168 @@ class SSD1306Ascii : public Print
      */
     void setFont(const uint8_t *font)
     {
-        m_font = font;
-        if (font && fontSize() == 1)
+        setFont(Font(font));
+    }
+    /**
+     * @brief Set the current font with its table of glyph offsets.
+     *
+     * @param[in] index Offsets of the font's characters, e.g.
+     *            glyphIndex<Arial14>.
+     */
+    template <const uint8_t *Table>
+    void setFont(const GlyphOffsets<Table> &index)
+    {
+        setFont(Font(index));
+    }
+    /**
+     * @brief Render into a RAM copy of display RAM.
+     *
+     * write(), clear() and the ticker update the copy and record the changed
+     * columns of each page.  display() or flush() sends only the changed
+     * spans.  The copy starts blank and fully changed.
+     *
+     * @param[in] buf The frame buffer, nullptr to write to the controller.
+     * @param[in] size Size of buf, at least displayWidth() * displayRows()
+     *            bytes.  Use displayWidth() * 8 bytes when a display with
+     *            fewer than eight rows scrolls RAM; pages outside the buffer
+     *            are dropped.
+     * @return false if buf is too small or begin() has not been called.
+     * @note Pending output is sent first.  Call setCursor() after
+     *       disabling the frame buffer.
+     */
+    bool setFrameBuffer(uint8_t *buf, size_t size)
+    {
+        flush();
+        m_frameBuffer = nullptr;
+        m_hashes = nullptr;
+        if (!buf)
         {
-            m_letterSpacing = 0;
+            return true;
         }
-        else
+        if (!m_displayWidth || size < (size_t)m_displayWidth * displayRows())
+        {
+            return false;
+        }
+        m_fbCol0 = 0;
+        m_fbPage0 = 0;
+        m_fbWidth = m_displayWidth;
+        m_fbPages = size / m_fbWidth > 8 ? 8 : size / m_fbWidth;
+        memset(buf, 0, m_fbWidth * m_fbPages);
+        for (uint8_t p = 0; p < m_fbPages; p++)
         {
-            m_letterSpacing = 1;
+            m_dirtyLo[p] = 0;
+            m_dirtyHi[p] = m_fbWidth - 1;
         }
+        m_frameBuffer = buf;
+        return true;
+    }
+    /**
+     * @brief Detect changes with a hash per SEGMENT_HASH_COLS columns of each
+     *        page instead of a copy of display RAM.
+     *
+     * render() draws the screen page by page into the scratch buffer and
+     * sends only the segments whose hash changed.  Each pass calls the
+     * draw function, so render() costs the CPU time of one draw per pass.
+     * A scratch buffer of SEGMENT_HASH_COLS bytes uses the least RAM but
+     * takes displayWidth() / SEGMENT_HASH_COLS passes per page, 64 on a
+     * 128x64 display; a scratch buffer of a full page takes one pass per
+     * page.
+     *
+     * @param[in] hashes Hash storage, nullptr to write to the controller.
+     * @param[in] count Number of hashes, displayRows() times the segments
+     *            per page.  Pages without hashes are always sent.
+     * @param[in] scratch Render buffer for one pass.
+     * @param[in] size Size of scratch, a multiple of SEGMENT_HASH_COLS.
+     * @return false if the buffers are too small or begin() has not been
+     *         called.
+     * @note The first render() sends every segment.  Draw only from
+     *       render() while segment hashes are set.
+     */
+    bool setSegmentHashes(uint16_t *hashes, size_t count, uint8_t *scratch, size_t size)
+    {
+        setFrameBuffer(nullptr, 0);
+        if (!hashes)
+        {
+            return true;
+        }
+        uint8_t segs = (m_displayWidth + SEGMENT_HASH_COLS - 1) / SEGMENT_HASH_COLS;
+        if (!segs || count < (size_t)segs * displayRows() || size < SEGMENT_HASH_COLS)
+        {
+            return false;
+        }
+        m_hashes = hashes;
+        m_hashPages = count / segs > 8 ? 8 : count / segs;
+        m_hashValid = false;
+        m_scratch = scratch;
+        size -= size % SEGMENT_HASH_COLS;
+        m_scratchCols = size > m_displayWidth ? m_displayWidth : size;
+        return true;
+    }
+    /**
+     * @brief Draw the screen with change detection, see setSegmentHashes().
+     *
+     * @param[in] draw Function that draws the whole screen on a blank
+     *            display.  It is called once per pass and must draw the
+     *            same screen each time.
+     * @param[in] ctx Argument passed to draw.
+     * @note Without segment hashes draw is called once.
+     */
+    void render(void (*draw)(SSD1306Ascii &display, void *ctx), void *ctx = nullptr)
+    {
+        if (!m_hashes)
+        {
+            draw(*this, ctx);
+            return;
+        }
+        uint8_t segs = (m_displayWidth + SEGMENT_HASH_COLS - 1) / SEGMENT_HASH_COLS;
+#if INCLUDE_SCROLLING
+        uint8_t startLine = m_startLine;
+#endif // INCLUDE_SCROLLING
+        for (uint8_t r = 0; r < displayRows(); r++)
+        {
+#if INCLUDE_SCROLLING
+            uint8_t page = (r + m_pageOffset) & 7;
+#else  // INCLUDE_SCROLLING
+            uint8_t page = r;
+#endif // INCLUDE_SCROLLING
+            for (uint8_t c0 = 0; c0 < m_displayWidth; c0 += m_scratchCols)
+            {
+                uint8_t n = m_displayWidth - c0 < m_scratchCols ? m_displayWidth - c0 : m_scratchCols;
+                // Capture the pass in the scratch buffer.
+                memset(m_scratch, 0, n);
+                m_frameBuffer = m_scratch;
+                m_fbCol0 = c0;
+                m_fbPage0 = page;
+                m_fbWidth = n;
+                m_fbPages = 1;
+                draw(*this, ctx);
+                m_frameBuffer = nullptr;
+                for (uint8_t c = 0; c < n; c += SEGMENT_HASH_COLS)
+                {
+                    uint8_t len = n - c < SEGMENT_HASH_COLS ? n - c : SEGMENT_HASH_COLS;
+                    uint16_t hash = crc16(m_scratch + c, len);
+                    uint16_t *h = page < m_hashPages
+                                      ? m_hashes + page * segs + (c0 + c) / SEGMENT_HASH_COLS
+                                      : nullptr;
+                    if (h && m_hashValid && *h == hash)
+                    {
+                        continue;
+                    }
+                    if (h)
+                    {
+                        *h = hash;
+                    }
+                    sendSpan(page, c0 + c, m_scratch + c, len);
+                }
+            }
+        }
+#if INCLUDE_SCROLLING
+        if (m_startLine != startLine)
+        {
+            ssd1306WriteCmd(SSD1306_SETSTARTLINE | m_startLine);
+        }
+#endif // INCLUDE_SCROLLING
+        m_hashValid = true;
     }
     /**
      * @brief Set letter-spacing.  setFont() will restore default letter-spacing.
@@ -583,10 +1407,15 @@ class SSD1306Ascii : public Print
         if (row < displayRows())
         {
             m_row = row;
+            if (m_frameBuffer)
+            {
+                return;
+            }
+            setPageMode();
 #if INCLUDE_SCROLLING
-            ssd1306WriteCmd(SSD1306_SETSTARTPAGE | ((m_row + m_pageOffset) & 7));
+            ssd1306WriteCmdBuf(SSD1306_SETSTARTPAGE | ((m_row + m_pageOffset) & 7));
 #else  // INCLUDE_SCROLLING
-            ssd1306WriteCmd(SSD1306_SETSTARTPAGE | m_row);
+            ssd1306WriteCmdBuf(SSD1306_SETSTARTPAGE | m_row);
 #endif // INCLUDE_SCROLLING
         }
     }
@@ -600,17 +1429,29 @@ class SSD1306Ascii : public Print
     {
         writeDisplay(c, SSD1306_MODE_CMD);
     }
+    /**
+     * @brief Write a command byte to the display controller.
+     *
+     * @param[in] c The command byte.
+     * @note The byte may be buffered with other command bytes until a call to
+     *       ssd1306WriteCmd, a write to display RAM or flush().
+     */
+    void ssd1306WriteCmdBuf(uint8_t c)
+    {
+        writeDisplay(c, SSD1306_MODE_CMD_BUF);
+    }
     /**
      * @brief Write a byte to RAM in the display controller.
      *
      * @param[in] c The data byte.
-     * @note The byte will immediately be sent to the controller.
+     * @note The byte will immediately be sent to the controller unless a
+     *       frame buffer is set.
      */
     void ssd1306WriteRam(uint8_t c)
     {
         if (m_col < m_displayWidth)
         {
-            writeDisplay(c ^ m_invertMask, SSD1306_MODE_RAM);
+            writeRam(c ^ m_invertMask, SSD1306_MODE_RAM);
             m_col++;
         }
     }
@@ -622,6 +1463,11 @@ class SSD1306Ascii : public Print
      *       or ssd1306WriteRam.
      */
     void ssd1306WriteRamBuf(uint8_t c)
+    {
+        writeRamBufInverted(c ^ m_invertMask);
+    }
+    // Write a byte with the invert mask already applied.
+    void writeRamBufInverted(uint8_t c)
     {
         if (m_skip)
         {
@@ -629,7 +1475,7 @@ class SSD1306Ascii : public Print
         }
         else if (m_col < m_displayWidth)
         {
-            writeDisplay(c ^ m_invertMask, SSD1306_MODE_RAM_BUF);
+            writeRam(c, SSD1306_MODE_RAM_BUF);
             m_col++;
         }
     }
@@ -651,14 +1497,21 @@ class SSD1306Ascii : public Print
     size_t strWidth(const char *str) const
     {
         size_t sw = 0;
-        while (*str)
+        Utf8Decoder utf8;
+        uint16_t c[2];
+        for (bool end = false; !end;)
         {
-            uint8_t cw = charWidth(*str++);
-            if (cw == 0)
+            end = !*str;
+            uint8_t n = end ? utf8.finish(c) : decode(utf8, *str++, c);
+            for (uint8_t i = 0; i < n; i++)
             {
-                return 0;
+                uint8_t cw = charWidth(c[i]);
+                if (cw == 0)
+                {
+                    return 0;
+                }
+                sw += cw + letterSpacing();
             }
-            sw += cw + letterSpacing();
         }
         return sw;
     }
@@ -737,7 +1590,7 @@ class SSD1306Ascii : public Print
             return 0;
         }
         setFont(state->font);
-        m_magFactor = state->mag2X ? 2 : 1;
+        setMag(state->mag2X ? 2 : 1);
         if (state->init)
         {
             clear(state->bgnCol, state->endCol, state->row, state->row + fontRows() - 1);
@@ -755,9 +1608,16 @@ class SSD1306Ascii : public Print
         for (uint8_t i = 0; i < state->nQueue; i++)
         {
             const char *str = state->queue[i];
-            while (*str && m_col <= state->endCol)
+            Utf8Decoder utf8;
+            uint16_t c[2];
+            for (bool end = false; !end && m_col <= state->endCol;)
             {
-                write(*str++);
+                end = !*str;
+                uint8_t n = end ? utf8.finish(c) : decode(utf8, *str++, c);
+                for (uint8_t k = 0; k < n; k++)
+                {
+                    writeChar(c[k]);
+                }
             }
             if (m_col > state->endCol)
             {
@@ -783,10 +1643,28 @@ class SSD1306Ascii : public Print
         else
         {
             state->skip++;
-            if (state->skip >= charSpacing(*state->queue[0]))
+            // Measure and skip the whole first character of the text.
+            const char *str = state->queue[0];
+            Utf8Decoder utf8;
+            uint16_t c[2];
+            uint8_t n = 0;
+            while (*str && !n)
+            {
+                n = decode(utf8, *str++, c);
+            }
+            if (n == 2)
+            {
+                // The byte after a truncated sequence starts the next one.
+                str--;
+            }
+            else if (!n)
+            {
+                n = utf8.finish(c);
+            }
+            if (!n || state->skip >= charSpacing(c[0]))
             {
                 state->skip = 0;
-                state->queue[0]++;
+                state->queue[0] = str;
                 if (*state->queue[0] == 0 && state->nQueue > 1)
                 {
                     state->nQueue--;
@@ -802,23 +1680,97 @@ class SSD1306Ascii : public Print
     /**
      * @brief Display a character.
      *
-     * @param[in] c The character to display.
+     * @param[in] ch The character, or the next byte of UTF-8 text.
      * @return one for success else zero.
      */
-    size_t write(uint8_t ch)
+    size_t write(uint8_t ch) override
+    {
+        uint16_t c[2];
+        uint8_t n = decode(m_utf8, ch, c);
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if (!writeChar(c[i]))
+            {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    /**
+     * @brief Display a string.
+     *
+     * Consecutive characters of the font are rendered together, one
+     * page of the whole run at a time, so a line is addressed once per
+     * page instead of once per character.
+     *
+     * @param[in] buffer The characters to display, UTF-8 in UTF-8 mode.
+     * @param[in] size The number of bytes.
+     * @return The number of bytes written.
+     */
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        uint16_t run[GLYPH_RUN_SIZE];
+        uint8_t runFonts[GLYPH_RUN_SIZE];
+        size_t nRun = 0;
+        size_t n = 0;
+        for (; n < size; n++)
+        {
+            uint16_t c[2];
+            uint8_t nc = decode(m_utf8, buffer[n], c);
+            uint8_t i = 0;
+            for (; i < nc; i++)
+            {
+                int8_t k = m_font ? findGlyph(c[i], &run[nRun]) : -1;
+                if (k >= 0)
+                {
+                    runFonts[nRun++] = k;
+                    if (nRun == GLYPH_RUN_SIZE)
+                    {
+                        writeRun(run, runFonts, nRun);
+                        nRun = 0;
+                    }
+                    continue;
+                }
+                if (nRun)
+                {
+                    writeRun(run, runFonts, nRun);
+                    nRun = 0;
+                }
+                if (!writeChar(c[i]))
+                {
+                    break;
+                }
+            }
+            if (i < nc)
+            {
+                break;
+            }
+        }
+        if (nRun)
+        {
+            writeRun(run, runFonts, nRun);
+        }
+        return n;
+    }
+    using Print::write;
+
+  protected:
+    /**
+     * @brief Display a decoded character.
+     *
+     * @param[in] ch The character.
+     * @return one for success else zero.
+     */
+    size_t writeChar(uint16_t ch)
     {
         if (!m_font)
         {
             return 0;
         }
-        uint8_t w = readFontByte(m_font + FONT_WIDTH);
-        uint8_t h = readFontByte(m_font + FONT_HEIGHT);
-        uint8_t nr = (h + 7) / 8;
-        uint8_t first = readFontByte(m_font + FONT_FIRST_CHAR);
-        uint8_t count = readFontByte(m_font + FONT_CHAR_COUNT);
-        const uint8_t *base = m_font + FONT_WIDTH_TABLE;
-
-        if (ch < first || ch >= (first + count))
+        uint8_t nr = m_fontChain ? m_fontChain->rows() : m_font.rows();
+        uint16_t glyph;
+        int8_t k = findGlyph(ch, &glyph);
+        if (k < 0)
         {
             if (ch == '\r')
             {
@@ -828,7 +1780,7 @@ class SSD1306Ascii : public Print
             if (ch == '\n')
             {
                 setCol(0);
-                uint8_t fr = m_magFactor * nr;
+                uint8_t fr = m_magY * nr;
 #if INCLUDE_SCROLLING
                 uint8_t dr = displayRows();
                 uint8_t tmpRow = m_row + fr;
@@ -855,85 +1807,410 @@ class SSD1306Ascii : public Print
             }
             return 0;
         }
-        ch -= first;
+        uint8_t font = k;
+        return writeRun(&glyph, &font, 1);
+    }
+    /**
+     * @brief Render a run of characters.
+     *
+     * Characters of fonts with fewer rows than the run are padded with
+     * blank pages.
+     *
+     * @param[in] glyphs Indices of characters in their fonts.
+     * @param[in] fonts Font of each character, see runFont().
+     * @param[in] n Number of characters, at most GLYPH_RUN_SIZE.
+     * @return n.
+     */
+    size_t writeRun(const uint16_t *glyphs, const uint8_t *fonts, size_t n)
+    {
+        const uint8_t *base[GLYPH_RUN_SIZE];
+        uint8_t width[GLYPH_RUN_SIZE];
+        // Compressed characters are decoded as they are written.
+        RleDecoder rle[GLYPH_RUN_SIZE];
+        uint8_t nr = 0;
         uint8_t s = letterSpacing();
-        uint8_t thieleShift = 0;
-        if (fontSize() < 2)
+        uint8_t scol = m_col;
+        uint8_t srow = m_row;
+        uint8_t skip = m_skip;
+        // Cached characters as sent to display RAM, nullptr if not cached.
+        const uint8_t *cached[GLYPH_RUN_SIZE];
+        if (m_glyphCache)
         {
-            // Fixed width font.
-            base += nr * w * ch;
+            m_glyphCache->beginRun();
         }
-        else
+        // Columns written to each page, ssd1306WriteRamBuf() drops the rest.
+        uint16_t span = 0;
+        for (size_t i = 0; i < n; i++)
         {
-            if (h & 7)
+            const Font &font = runFont(fonts[i]);
+            width[i] = font.glyphWidth(glyphs[i]);
+            base[i] = font.glyph(glyphs[i]);
+            cached[i] = m_glyphCache ? cacheGlyph(font, glyphs[i], base[i], width[i]) : nullptr;
+            if (font.format() == FONT_FORMAT_RLE)
             {
-                thieleShift = 8 - (h & 7);
+                rle[i].begin(base[i]);
             }
-            uint16_t index = 0;
-            for (uint8_t i = 0; i < ch; i++)
+            if (font.rows() > nr)
             {
-                index += readFontByte(base + i);
+                nr = font.rows();
             }
-            w = readFontByte(base + ch);
-            base += nr * index + count;
+            span += m_magX * width[i] + s;
         }
-        uint8_t scol = m_col;
-        uint8_t srow = m_row;
-        uint8_t skip = m_skip;
+        span = span > skip ? span - skip : 0;
+        if (scol + span > m_displayWidth)
+        {
+            span = scol < m_displayWidth ? m_displayWidth - scol : 0;
+        }
+        uint8_t rows = m_magY * nr;
+        // A window costs eight command bytes and five more to return to
+        // page mode, more than the page changes of a run under four rows.
+        bool window = rows > 3 && span && srow + rows <= displayRows() &&
+                      setWindow(scol, scol + span - 1, srow, srow + rows - 1);
         for (uint8_t r = 0; r < nr; r++)
         {
-            for (uint8_t m = 0; m < m_magFactor; m++)
+            for (uint8_t m = 0; m < m_magY; m++)
             {
                 skipColumns(skip);
-                if (r || m)
+                if ((r || m) && window)
+                {
+                    // The controller moves to the next page of the window.
+                    m_col = scol;
+                    m_row++;
+                }
+                else if (r || m)
                 {
                     setCursor(scol, m_row + 1);
                 }
-                for (uint8_t c = 0; c < w; c++)
+                for (size_t i = 0; i < n && m_col < m_displayWidth; i++)
                 {
-                    uint8_t b = readFontByte(base + c + r * w);
-                    if (thieleShift && (r + 1) == nr)
+                    const Font &font = runFont(fonts[i]);
+                    bool compressed = font.format() == FONT_FORMAT_RLE;
+                    uint8_t w = width[i];
+                    const uint8_t *p = base[i] + r * w;
+                    if (r >= font.rows())
+                    {
+                        for (uint16_t c = m_magX * w; c; c--)
+                        {
+                            ssd1306WriteRamBuf(0);
+                        }
+                    }
+                    else if (cached[i])
+                    {
+                        uint16_t cols = m_magX * w;
+                        const uint8_t *q = cached[i] + (r * m_magY + m) * cols;
+                        for (uint16_t c = 0; c < cols; c++)
+                        {
+                            writeRamBufInverted(q[c]);
+                        }
+                    }
+                    else if (!font.thieleShift() && !compressed && m_magX == 1 && m_magY == 1)
                     {
-                        b >>= thieleShift;
+                        // Paged fonts at 1X are copied without modification.
+                        for (uint8_t c = 0; c < w; c++)
+                        {
+                            ssd1306WriteRamBuf(readFontByte(p + c));
+                        }
                     }
-                    if (m_magFactor == 2)
+                    else
                     {
-                        b = m ? b >> 4 : b & 0XF;
-                        b = readFontByte(scaledNibble + b);
-                        ssd1306WriteRamBuf(b);
+                        if (compressed && m)
+                        {
+                            // Decode the row again for each magnified page.
+                            rle[i].begin(base[i]);
+                            for (uint16_t k = r * w; k; k--)
+                            {
+                                rle[i].next();
+                            }
+                        }
+                        for (uint8_t c = 0; c < w; c++)
+                        {
+                            uint8_t b = compressed ? rle[i].next() : readFontByte(p + c);
+                            b = pageByte(font, b, r, m);
+                            for (uint8_t x = 0; x < m_magX; x++)
+                            {
+                                ssd1306WriteRamBuf(b);
+                            }
+                        }
+                    }
+                    for (uint8_t k = 0; k < s; k++)
+                    {
+                        ssd1306WriteRamBuf(0);
                     }
-                    ssd1306WriteRamBuf(b);
                 }
-                for (uint8_t i = 0; i < s; i++)
+            }
+        }
+        if (window)
+        {
+            setCursor(m_col, srow);
+        }
+        else
+        {
+            setRow(srow);
+        }
+        return n;
+    }
+    // Shift and magnify a byte of character row r for magnified page m.
+    uint8_t pageByte(const Font &font, uint8_t b, uint8_t r, uint8_t m) const
+    {
+        if (font.thieleShift() && r + 1 == font.rows())
+        {
+            b >>= font.thieleShift();
+        }
+        return m_magY > 1 ? magSpreadPage(b, m_magY, m) : b;
+    }
+    /**
+     * @brief Find a character in the glyph cache or render it into the cache.
+     *
+     * @param[in] font The character's font.
+     * @param[in] glyph Character index in the font.
+     * @param[in] data The character's data.
+     * @param[in] w The character's width.
+     * @return Pages of magX * w bytes, nullptr if the character does not fit
+     *         an entry or the run uses every entry.
+     */
+    const uint8_t *cacheGlyph(const Font &font, uint16_t glyph, const uint8_t *data, uint8_t w)
+    {
+        uint8_t mag = m_magX << 4 | m_magY;
+        const uint8_t *found = m_glyphCache->find(font.table(), glyph, mag, m_invertMask);
+        uint16_t cols = m_magX * w;
+        uint8_t pages = m_magY * font.rows();
+        if (found || (uint32_t)cols * pages > m_glyphCache->slotSize())
+        {
+            return found;
+        }
+        uint8_t *out = m_glyphCache->insert(font.table(), glyph, mag, m_invertMask);
+        if (!out)
+        {
+            return nullptr;
+        }
+        RleDecoder rle;
+        rle.begin(data);
+        bool compressed = font.format() == FONT_FORMAT_RLE;
+        for (uint8_t r = 0; r < font.rows(); r++)
+        {
+            for (uint8_t c = 0; c < w; c++)
+            {
+                uint8_t b = compressed ? rle.next() : readFontByte(data + r * w + c);
+                for (uint8_t m = 0; m < m_magY; m++)
                 {
-                    ssd1306WriteRamBuf(0);
+                    uint8_t *q = out + (r * m_magY + m) * cols + c * m_magX;
+                    memset(q, pageByte(font, b, r, m) ^ m_invertMask, m_magX);
                 }
             }
         }
-        setRow(srow);
-        return 1;
+        return out;
     }
-
-  protected:
-    uint16_t fontSize() const
+    /**
+     * @param[in] k Font number, zero for the current font.
+     * @return The current font or font k of the font chain.
+     */
+    const Font &runFont(uint8_t k) const
+    {
+        return k ? m_fontChain->font(k) : m_font;
+    }
+    /**
+     * @brief Find a character in the current font or the font chain.
+     *
+     * @param[in] c Character code.
+     * @param[out] glyph Index of the character in its font.
+     * @return Font number for runFont(), -1 if no font has the character.
+     */
+    int8_t findGlyph(uint16_t c, uint16_t *glyph) const
+    {
+        int8_t k;
+        if (m_fontChain)
+        {
+            k = m_fontChain->resolve(c, glyph);
+        }
+        else
+        {
+            int32_t g = m_font.index(c);
+            *glyph = g;
+            k = g < 0 ? -1 : 0;
+        }
+        // Show malformed UTF-8 as '?' in fonts without U+FFFD.
+        return k < 0 && c == 0XFFFD ? findGlyph('?', glyph) : k;
+    }
+    /**
+     * @brief Decode the next byte of text in the current mode.
+     *
+     * @param[in,out] utf8 Decoder state for UTF-8 mode.
+     * @param[in] b The next byte.
+     * @param[out] c The decoded characters, room for two.
+     * @return Number of characters in c.
+     */
+    uint8_t decode(Utf8Decoder &utf8, uint8_t b, uint16_t c[2]) const
+    {
+        if (!m_utf8Mode)
+        {
+            c[0] = b;
+            return 1;
+        }
+        return utf8.decode(b, c);
+    }
+    /**
+     * @brief Select a rectangle of display RAM for the next data bytes.
+     *
+     * The controller is switched to horizontal addressing mode and fills
+     * the window page by page.  setCol() and setRow() restore page
+     * addressing mode.
+     *
+     * @param[in] c0 Starting column.
+     * @param[in] c1 Ending column.
+     * @param[in] r0 Starting row.
+     * @param[in] r1 Ending row.
+     * @return false if the controller has no address window or the rows
+     *         wrap around the end of RAM.
+     */
+    bool setWindow(uint8_t c0, uint8_t c1, uint8_t r0, uint8_t r1)
+    {
+#if INCLUDE_SCROLLING
+        r0 = (r0 + m_pageOffset) & 7;
+        r1 = (r1 + m_pageOffset) & 7;
+#endif // INCLUDE_SCROLLING
+        if (!m_addrWindow || m_frameBuffer || r1 < r0)
+        {
+            return false;
+        }
+        ssd1306WriteCmdBuf(SSD1306_MEMORYMODE);
+        ssd1306WriteCmdBuf(SSD1306_HORIZONTAL_MODE);
+        ssd1306WriteCmdBuf(SSD1306_COLUMNADDR);
+        ssd1306WriteCmdBuf(c0 + m_colOffset);
+        ssd1306WriteCmdBuf(c1 + m_colOffset);
+        ssd1306WriteCmdBuf(SSD1306_PAGEADDR);
+        ssd1306WriteCmdBuf(r0);
+        ssd1306WriteCmdBuf(r1);
+        m_pageMode = false;
+        return true;
+    }
+    /**
+     * @brief Send the changed spans of the frame buffer to the controller.
+     *
+     * Display classes call it from flush() before they drain the bus.
+     */
+    void sendFrameBuffer()
+    {
+        if (!m_frameBuffer)
+        {
+            return;
+        }
+        for (uint8_t p = 0; p < m_fbPages; p++)
+        {
+            uint8_t lo = m_dirtyLo[p];
+            uint8_t hi = m_dirtyHi[p];
+            if (lo > hi)
+            {
+                continue;
+            }
+            sendSpan(p, lo, m_frameBuffer + p * m_fbWidth + lo, hi - lo + 1);
+            m_dirtyLo[p] = 0XFF;
+            m_dirtyHi[p] = 0;
+        }
+    }
+    // Write bytes to a RAM page starting at a display column.
+    void sendSpan(uint8_t page, uint8_t col, const uint8_t *data, uint8_t len)
     {
-        return (readFontByte(m_font) << 8) | readFontByte(m_font + 1);
+        col += m_colOffset;
+        setPageMode();
+        ssd1306WriteCmdBuf(SSD1306_SETLOWCOLUMN | (col & 0XF));
+        ssd1306WriteCmdBuf(SSD1306_SETHIGHCOLUMN | (col >> 4));
+        ssd1306WriteCmdBuf(SSD1306_SETSTARTPAGE | page);
+        for (uint8_t i = 0; i < len; i++)
+        {
+            writeDisplay(data[i], SSD1306_MODE_RAM_BUF);
+        }
+    }
+    // CRC-16/CCITT of a segment.
+    static uint16_t crc16(const uint8_t *data, uint8_t len)
+    {
+        uint16_t crc = 0XFFFF;
+        for (uint8_t i = 0; i < len; i++)
+        {
+            crc ^= data[i] << 8;
+            for (uint8_t k = 0; k < 8; k++)
+            {
+                crc = crc & 0X8000 ? (crc << 1) ^ 0X1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+    void setPageMode()
+    {
+        if (!m_pageMode)
+        {
+            ssd1306WriteCmdBuf(SSD1306_MEMORYMODE);
+            ssd1306WriteCmdBuf(SSD1306_PAGE_MODE);
+            m_pageMode = true;
+        }
+    }
+    // Write a byte at the cursor to the frame buffer or the controller.
+    void writeRam(uint8_t b, uint8_t mode)
+    {
+        if (!m_frameBuffer)
+        {
+            writeDisplay(b, mode);
+            return;
+        }
+#if INCLUDE_SCROLLING
+        uint8_t page = (m_row + m_pageOffset) & 7;
+#else  // INCLUDE_SCROLLING
+        uint8_t page = m_row;
+#endif // INCLUDE_SCROLLING
+        page -= m_fbPage0;
+        uint8_t col = m_col - m_fbCol0;
+        if (page >= m_fbPages || col >= m_fbWidth)
+        {
+            return;
+        }
+        uint8_t *p = m_frameBuffer + page * m_fbWidth + col;
+        if (*p != b)
+        {
+            *p = b;
+            if (col < m_dirtyLo[page])
+            {
+                m_dirtyLo[page] = col;
+            }
+            if (col > m_dirtyHi[page])
+            {
+                m_dirtyHi[page] = col;
+            }
+        }
     }
     virtual void writeDisplay(uint8_t b, uint8_t mode) = 0;
-    uint8_t m_col;           // Cursor column.
-    uint8_t m_row;           // Cursor RAM row.
-    uint8_t m_displayWidth;  // Display width.
-    uint8_t m_displayHeight; // Display height.
-    uint8_t m_colOffset;     // Column offset RAM to SEG.
-    uint8_t m_letterSpacing; // Letter-spacing in pixels.
+    uint8_t m_col = 0;           // Cursor column.
+    uint8_t m_row = 0;           // Cursor RAM row.
+    uint8_t m_displayWidth = 0;  // Display width, zero until init().
+    uint8_t m_displayHeight = 0; // Display height.
+    uint8_t m_colOffset = 0;     // Column offset RAM to SEG.
+    uint8_t m_letterSpacing;     // Letter-spacing in pixels.
+    bool m_addrWindow;           // Controller supports address windows.
+    bool m_pageMode;             // Controller is in page addressing mode.
 #if INCLUDE_SCROLLING
     uint8_t m_startLine;                        // Top line of display
     uint8_t m_pageOffset;                       // Top page of RAM window.
     uint8_t m_scrollMode = INITIAL_SCROLL_MODE; // Scroll mode for newline.
 #endif                                          // INCLUDE_SCROLLING
     uint8_t m_skip = 0;
-    const uint8_t *m_font = nullptr; // Current font.
+    Font m_font;                     // Current font.
+    FontArena *m_fontArena = nullptr; // RAM copies of fonts.
+    GlyphCacheStore *m_glyphCache = nullptr; // Rendered characters.
+    FontChain *m_fontChain = nullptr;        // Fallback fonts.
     uint8_t m_invertMask = 0;        // font invert mask
-    uint8_t m_magFactor = 1;         // Magnification factor.
+    bool m_utf8Mode = false;         // Decode UTF-8 in write().
+    Utf8Decoder m_utf8;              // UTF-8 decoder state.
+    uint8_t m_magX = 1;              // Horizontal magnification factor.
+    uint8_t m_magY = 1;              // Vertical magnification factor.
+    uint8_t *m_frameBuffer = nullptr; // RAM copy of display RAM.
+    uint8_t m_fbCol0;                 // First column in the frame buffer.
+    uint8_t m_fbPage0;                // First RAM page in the frame buffer.
+    uint8_t m_fbWidth;                // Columns per frame buffer page.
+    uint8_t m_fbPages;                // Pages in the frame buffer.
+    uint8_t m_dirtyLo[8];             // First changed column, 0XFF if clean.
+    uint8_t m_dirtyHi[8];             // Last changed column.
+    uint16_t *m_hashes = nullptr;     // Segment hashes by RAM page.
+    uint8_t m_hashPages;              // Pages with hashes.
+    bool m_hashValid;                 // Hashes match display RAM.
+    uint8_t *m_scratch;               // Render buffer for one pass.
+    uint8_t m_scratchCols;            // Columns per render pass.
 };
 #endif // SSD1306Ascii_h
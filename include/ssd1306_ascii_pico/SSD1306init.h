@@ -40,6 +40,16 @@
 #define SSD1306_SETHIGHCOLUMN 0x10
 /** Set Memory Addressing Mode. */
 #define SSD1306_MEMORYMODE 0x20
+/** Set Column Address window for Horizontal or Vertical Addressing Mode. */
+#define SSD1306_COLUMNADDR 0x21
+/** Set Page Address window for Horizontal or Vertical Addressing Mode. */
+#define SSD1306_PAGEADDR 0x22
+/** Memory Addressing Mode argument for Horizontal Addressing Mode. */
+#define SSD1306_HORIZONTAL_MODE 0x00
+/** Memory Addressing Mode argument for Vertical Addressing Mode. */
+#define SSD1306_VERTICAL_MODE 0x01
+/** Memory Addressing Mode argument for Page Addressing Mode. */
+#define SSD1306_PAGE_MODE 0x02
 /** Set display RAM display start line register from 0 - 63. */
 #define SSD1306_SETSTARTLINE 0x40
 /** Set Display Contrast to one of 256 steps. */
@@ -117,6 +127,11 @@ struct DevType {
    * Column offset RAM to display.  Used to pick start column of SH1106.
    */
   const uint8_t colOffset;
+  /**
+   * Non-zero if the controller supports column and page address windows in
+   * horizontal addressing mode.  Zero, the default, for SH1106.
+   */
+  const uint8_t addrWindow;
 };
 //------------------------------------------------------------------------------
 /** Initialization commands for a 64x48 Micro OLED display (by r7) */
@@ -144,7 +159,8 @@ static const DevType MEM_TYPE MicroOLED64x48 = {
   sizeof(MicroOLED64x48init),
   64,
   48,
-  32
+  32,
+  1
 };
 //------------------------------------------------------------------------------
 // this section is based on
@@ -176,7 +192,8 @@ static const DevType MEM_TYPE SSD1306_96x16 = {
   sizeof(SSD1306_96x16init),
   96,
   16,
-  0
+  0,
+  1
 };
 //------------------------------------------------------------------------------
 // this section is based on https://github.com/adafruit/Adafruit_SSD1306
@@ -206,7 +223,8 @@ static const DevType MEM_TYPE Adafruit128x32 = {
   sizeof(Adafruit128x32init),
   128,
   32,
-  0
+  0,
+  1
 };
 //------------------------------------------------------------------------------
 // This section is based on https://github.com/adafruit/Adafruit_SSD1306
@@ -236,7 +254,8 @@ static const DevType MEM_TYPE Adafruit128x64 = {
   sizeof(Adafruit128x64init),
   128,
   64,
-  0
+  0,
+  1
 };
 //------------------------------------------------------------------------------
 // This section is based on https://github.com/stanleyhuangyc/MultiLCD
@@ -264,6 +283,7 @@ static const DevType MEM_TYPE SH1106_128x64 =  {
   sizeof(SH1106_128x64init),
   128,
   64,
-  2    // SH1106 is a 132x64 controller.  Use middle 128 columns.
+  2,   // SH1106 is a 132x64 controller.  Use middle 128 columns.
+  0    // SH1106 has no address window commands.
 };
 #endif  // SSD1306init_h
@@ -21,7 +21,7 @@
 #define readFontByte(addr) pgm_read_byte(addr)
 #else  // __AVR__
 /** declare a font. */
-#define GLCDFONTDECL(_n) static const uint8_t _n[]
+#define GLCDFONTDECL(_n) static constexpr uint8_t _n[]
 /** Fake read from flash. */
 #define readFontByte(addr) (*(const unsigned char *)(addr))
 #endif  // __AVR__
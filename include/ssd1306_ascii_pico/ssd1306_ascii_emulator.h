@@ -0,0 +1,574 @@
+#pragma once
+
+#include "ssd1306_ascii_i2c.h"
+
+#include <cstdio>
+
+/**
+ * @class SSD1306Emulator
+ * @brief Model of an SSD1306 or SH1106 controller and its panel.
+ *
+ * The emulator consumes the byte stream a display class sends, either as
+ * I2C transfers with control bytes or as SPI bytes with the D/C level. It
+ * models display RAM, page, horizontal and vertical addressing, the column
+ * and page windows, segment remap, COM scan direction, start line, display
+ * offset, inverse and all-on modes. COM pin configuration, contrast and
+ * hardware scrolling are accepted and ignored.
+ *
+ * Panel pixels are reported upright for the remap and COM scan direction
+ * set by the SSD1306init.h sequences. Bus counters give the wire time of
+ * the stream at an I2C or SPI clock.
+ */
+class SSD1306Emulator
+{
+  public:
+    /** Controller families. */
+    enum Controller : uint8_t
+    {
+        SSD1306 = 0, ///< 128 column controller.
+        SH1106 = 1   ///< 132 column controller, page addressing only.
+    };
+    /** Number of RAM pages. */
+    static const uint8_t RAM_PAGES = 8;
+    /** Maximum number of RAM columns. */
+    static const uint8_t RAM_WIDTH = 132;
+
+    /**
+     * @brief Create the model of a panel in its reset state.
+     *
+     * @param[in] dev The device initialization structure of the panel.
+     * @param[in] type The controller family.
+     */
+    explicit SSD1306Emulator(const DevType *dev, Controller type = SSD1306)
+        : m_type(type), m_ramWidth(type == SH1106 ? 132 : 128),
+          m_width(readFontByte(&dev->lcdWidth)), m_height(readFontByte(&dev->lcdHeight)),
+          m_colOffset(readFontByte(&dev->colOffset))
+    {
+        reset();
+    }
+    /**
+     * @brief Set the controller to its power on state and clear RAM.
+     */
+    void reset()
+    {
+        memset(m_ram, 0, sizeof(m_ram));
+        m_mode = SSD1306_PAGE_MODE;
+        m_col = 0;
+        m_page = 0;
+        m_colStart = 0;
+        m_colEnd = m_ramWidth - 1;
+        m_pageStart = 0;
+        m_pageEnd = RAM_PAGES - 1;
+        m_startLine = 0;
+        m_offset = 0;
+        m_mux = 64;
+        m_remap = false;
+        m_comDec = false;
+        m_invert = false;
+        m_allOn = false;
+        m_on = false;
+        m_nArgs = 0;
+        m_argCount = 0;
+        resetCounters();
+    }
+    //----------------------------------------------------------------------------
+    /**
+     * @brief Consume one I2C transfer, without the address byte.
+     *
+     * @param[in] data Control and payload bytes.
+     * @param[in] len Number of bytes.
+     */
+    void i2cWrite(const uint8_t *data, size_t len)
+    {
+        m_transfers++;
+        m_i2cBytes += len + 1;
+        size_t i = 0;
+        while (i < len)
+        {
+            uint8_t control = data[i++];
+            bool dc = control & 0X40;
+            if (control & 0X80)
+            {
+                // Continuation bit: one byte, then another control byte.
+                if (i < len)
+                {
+                    write(dc, data[i++]);
+                }
+            }
+            else
+            {
+                while (i < len)
+                {
+                    write(dc, data[i++]);
+                }
+            }
+        }
+    }
+    /**
+     * @brief Consume one SPI byte.
+     *
+     * @param[in] dc The D/C pin level, true for display RAM.
+     * @param[in] b The byte.
+     */
+    void spiWrite(bool dc, uint8_t b)
+    {
+        write(dc, b);
+    }
+    //----------------------------------------------------------------------------
+    /**
+     * @brief Read a byte of display RAM.
+     *
+     * @param[in] col RAM column.
+     * @param[in] page RAM page.
+     * @return The byte, bit 0 is the top line of the page.
+     */
+    uint8_t ram(uint8_t col, uint8_t page) const
+    {
+        return col < m_ramWidth && page < RAM_PAGES ? m_ram[page][col] : 0;
+    }
+    /**
+     * @brief Read a panel pixel.
+     *
+     * @param[in] x Column, zero is the left edge.
+     * @param[in] y Row, zero is the top edge.
+     * @return true if the pixel is lit.
+     */
+    bool pixel(uint8_t x, uint8_t y) const
+    {
+        if (!m_on || x >= m_width || y >= m_height || y >= m_mux)
+        {
+            return false;
+        }
+        if (m_allOn)
+        {
+            return true;
+        }
+        uint8_t col = m_remap ? x + m_colOffset : m_ramWidth - 1 - m_colOffset - x;
+        uint8_t com = m_comDec ? y : m_height - 1 - y;
+        uint8_t line = (com + m_startLine + m_offset) & 0X3F;
+        bool on = (ram(col, line >> 3) >> (line & 7)) & 1;
+        return on != m_invert;
+    }
+    /**
+     * @brief Compare the panel with another emulator.
+     *
+     * @param[in] other The other panel.
+     * @return true if both panels show the same pixels.
+     */
+    bool samePixels(const SSD1306Emulator &other) const
+    {
+        if (other.m_width != m_width || other.m_height != m_height)
+        {
+            return false;
+        }
+        for (uint8_t y = 0; y < m_height; y++)
+        {
+            for (uint8_t x = 0; x < m_width; x++)
+            {
+                if (pixel(x, y) != other.pixel(x, y))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    /**
+     * @brief Save the panel as a binary PBM image.
+     *
+     * @param[in] path The file name.
+     * @return true for success.
+     */
+    bool writePbm(const char *path) const
+    {
+        FILE *file = fopen(path, "wb");
+        if (!file)
+        {
+            return false;
+        }
+        fprintf(file, "P4\n%u %u\n", m_width, m_height);
+        for (uint8_t y = 0; y < m_height; y++)
+        {
+            for (uint8_t x = 0; x < m_width; x += 8)
+            {
+                uint8_t b = 0;
+                for (uint8_t i = 0; i < 8; i++)
+                {
+                    b = (b << 1) | pixel(x + i, y);
+                }
+                fputc(b, file);
+            }
+        }
+        return fclose(file) == 0;
+    }
+    //----------------------------------------------------------------------------
+    /**
+     * @brief Clear the bus counters, e.g. at the start of a frame.
+     */
+    void resetCounters()
+    {
+        m_transfers = 0;
+        m_i2cBytes = 0;
+        m_cmdBytes = 0;
+        m_dataBytes = 0;
+    }
+    /**
+     * @return Number of I2C transfers.
+     */
+    uint32_t transferCount() const
+    {
+        return m_transfers;
+    }
+    /**
+     * @return Number of I2C bytes, address and control bytes included.
+     */
+    uint32_t i2cByteCount() const
+    {
+        return m_i2cBytes;
+    }
+    /**
+     * @return Number of command bytes.
+     */
+    uint32_t commandByteCount() const
+    {
+        return m_cmdBytes;
+    }
+    /**
+     * @return Number of display RAM bytes.
+     */
+    uint32_t dataByteCount() const
+    {
+        return m_dataBytes;
+    }
+    /**
+     * @brief Wire time of the counted I2C transfers.
+     *
+     * Each byte takes nine clocks with its ACK bit and each transfer adds
+     * one clock for the START and one for the STOP condition.
+     *
+     * @param[in] speed The I2C clock in Hz.
+     * @return The wire time in microseconds.
+     */
+    double i2cTimeUs(unsigned long speed) const
+    {
+        return (9.0 * m_i2cBytes + 2.0 * m_transfers) * 1e6 / speed;
+    }
+    /**
+     * @brief Wire time of the counted bytes on a 4-wire SPI bus.
+     *
+     * @param[in] speed The SPI clock in Hz.
+     * @return The wire time in microseconds.
+     */
+    double spiTimeUs(unsigned long speed) const
+    {
+        return 8.0 * (m_cmdBytes + m_dataBytes) * 1e6 / speed;
+    }
+
+  private:
+    void write(bool dc, uint8_t b)
+    {
+        if (dc)
+        {
+            m_dataBytes++;
+            data(b);
+        }
+        else
+        {
+            m_cmdBytes++;
+            command(b);
+        }
+    }
+
+    void data(uint8_t b)
+    {
+        if (m_col < m_ramWidth)
+        {
+            m_ram[m_page][m_col] = b;
+        }
+        if (m_type == SH1106)
+        {
+            // The column address stops at the last column.
+            if (m_col < m_ramWidth - 1)
+            {
+                m_col++;
+            }
+        }
+        else if (m_mode == SSD1306_HORIZONTAL_MODE)
+        {
+            if (m_col++ == m_colEnd)
+            {
+                m_col = m_colStart;
+                m_page = m_page == m_pageEnd ? m_pageStart : m_page + 1;
+            }
+        }
+        else if (m_mode == SSD1306_VERTICAL_MODE)
+        {
+            if (m_page++ == m_pageEnd)
+            {
+                m_page = m_pageStart;
+                m_col = m_col == m_colEnd ? m_colStart : m_col + 1;
+            }
+        }
+        else
+        {
+            // Page mode wraps within the page.
+            m_col = m_col == m_ramWidth - 1 ? 0 : m_col + 1;
+        }
+    }
+
+    // Number of argument bytes that follow a command byte.
+    uint8_t argCount(uint8_t c) const
+    {
+        switch (c)
+        {
+        case SSD1306_SETCONTRAST:
+        case SSD1306_SETMULTIPLEX:
+        case SSD1306_SETDISPLAYOFFSET:
+        case SSD1306_SETDISPLAYCLOCKDIV:
+        case SSD1306_SETPRECHARGE:
+        case SSD1306_SETCOMPINS:
+        case SSD1306_SETVCOMDETECT:
+            return 1;
+        }
+        if (m_type == SH1106)
+        {
+            return c == SH1106_SET_PUMP_MODE ? 1 : 0;
+        }
+        switch (c)
+        {
+        case SSD1306_MEMORYMODE:
+        case SSD1306_CHARGEPUMP:
+            return 1;
+        case SSD1306_COLUMNADDR:
+        case SSD1306_PAGEADDR:
+        case 0XA3: // Vertical scroll area.
+            return 2;
+        case 0X29: // Vertical and horizontal scroll.
+        case 0X2A:
+            return 5;
+        case 0X26: // Horizontal scroll.
+        case 0X27:
+            return 6;
+        }
+        return 0;
+    }
+
+    void command(uint8_t c)
+    {
+        if (m_argCount)
+        {
+            m_args[m_nArgs++] = c;
+            if (m_nArgs == m_argCount)
+            {
+                m_argCount = 0;
+                execute();
+            }
+            return;
+        }
+        m_cmd = c;
+        m_nArgs = 0;
+        m_argCount = argCount(c);
+        if (!m_argCount)
+        {
+            execute();
+        }
+    }
+
+    void execute()
+    {
+        // Column and page pointer commands only act in page mode on SSD1306.
+        bool pageMode = m_type == SH1106 || m_mode == SSD1306_PAGE_MODE;
+        uint8_t c = m_cmd;
+        if (c < 0X10)
+        {
+            if (pageMode)
+            {
+                m_col = (m_col & 0XF0) | c;
+            }
+        }
+        else if (c < 0X20)
+        {
+            if (pageMode)
+            {
+                m_col = ((c & 0XF) << 4) | (m_col & 0XF);
+            }
+        }
+        else if (c >= 0X40 && c < 0X80)
+        {
+            m_startLine = c & 0X3F;
+        }
+        else if ((c & 0XF8) == SSD1306_SETSTARTPAGE)
+        {
+            if (pageMode)
+            {
+                m_page = c & 7;
+            }
+        }
+        else
+        {
+            if (m_type == SH1106 && c >= SSD1306_MEMORYMODE && c <= SSD1306_PAGEADDR)
+            {
+                // SH1106 has no addressing mode or window commands.
+                return;
+            }
+            switch (c)
+            {
+            case SSD1306_MEMORYMODE:
+                if (m_args[0] < 3)
+                {
+                    m_mode = m_args[0];
+                }
+                break;
+            case SSD1306_COLUMNADDR:
+                m_colStart = m_args[0] & 0X7F;
+                m_colEnd = m_args[1] & 0X7F;
+                m_col = m_colStart;
+                break;
+            case SSD1306_PAGEADDR:
+                m_pageStart = m_args[0] & 7;
+                m_pageEnd = m_args[1] & 7;
+                m_page = m_pageStart;
+                break;
+            case SSD1306_SETMULTIPLEX:
+                m_mux = (m_args[0] & 0X3F) + 1;
+                break;
+            case SSD1306_SETDISPLAYOFFSET:
+                m_offset = m_args[0] & 0X3F;
+                break;
+            case SSD1306_SEGREMAP:
+            case SSD1306_SEGREMAP | 1:
+                m_remap = c & 1;
+                break;
+            case SSD1306_COMSCANINC:
+            case SSD1306_COMSCANDEC:
+                m_comDec = c == SSD1306_COMSCANDEC;
+                break;
+            case SSD1306_DISPLAYALLON_RESUME:
+            case SSD1306_DISPLAYALLON:
+                m_allOn = c == SSD1306_DISPLAYALLON;
+                break;
+            case SSD1306_NORMALDISPLAY:
+            case SSD1306_INVERTDISPLAY:
+                m_invert = c == SSD1306_INVERTDISPLAY;
+                break;
+            case SSD1306_DISPLAYOFF:
+            case SSD1306_DISPLAYON:
+                m_on = c == SSD1306_DISPLAYON;
+                break;
+            }
+        }
+    }
+
+    const Controller m_type;
+    const uint8_t m_ramWidth;
+    const uint8_t m_width;
+    const uint8_t m_height;
+    const uint8_t m_colOffset;
+    uint8_t m_ram[RAM_PAGES][RAM_WIDTH];
+    uint8_t m_mode;      // Memory addressing mode.
+    uint8_t m_col;       // Column pointer.
+    uint8_t m_page;      // Page pointer.
+    uint8_t m_colStart;  // Column window.
+    uint8_t m_colEnd;
+    uint8_t m_pageStart; // Page window.
+    uint8_t m_pageEnd;
+    uint8_t m_startLine; // RAM line shown on the first COM.
+    uint8_t m_offset;    // Display offset.
+    uint8_t m_mux;       // Multiplex ratio.
+    bool m_remap;        // Column 0 is on the left edge.
+    bool m_comDec;       // Line 0 is on the top edge.
+    bool m_invert;
+    bool m_allOn;
+    bool m_on;
+    uint8_t m_cmd;       // Command waiting for arguments.
+    uint8_t m_args[6];
+    uint8_t m_nArgs;
+    uint8_t m_argCount;
+    uint32_t m_transfers;
+    uint32_t m_i2cBytes;
+    uint32_t m_cmdBytes;
+    uint32_t m_dataBytes;
+};
+
+/**
+ * @class EmulatorI2CBus
+ * @brief I2C bus that feeds its transfers to an SSD1306Emulator.
+ */
+class EmulatorI2CBus : public I2CBusInterface
+{
+  public:
+    /**
+     * @brief Attach an emulator at an I2C address.
+     *
+     * @param[in] model The controller model.
+     * @param[in] addr The I2C address of the controller.
+     */
+    explicit EmulatorI2CBus(SSD1306Emulator &model, uint8_t addr = 0X3C)
+        : emulator(model), device(addr)
+    {
+    }
+
+  protected:
+    /**
+     * @return false, a NACK, if the transfer is for another address.
+     */
+    bool transfer(const uint8_t *data, size_t len) override
+    {
+        if (address != device)
+        {
+            return false;
+        }
+        emulator.i2cWrite(data, len);
+        return true;
+    }
+
+  private:
+    SSD1306Emulator &emulator;
+    uint8_t device;
+};
+
+/**
+ * @class EmulatorSpiBus
+ * @brief Host stand-in for SPIBus that feeds an SSD1306Emulator SPI bytes.
+ *
+ * SPIBus and SSD1306AsciiSpi need the Pico SDK. On the host attach an
+ * SSD1306AsciiI2C to this bus instead: the control bytes of each transfer
+ * set the D/C level and every other byte goes to spiWrite(), which is the
+ * stream SSD1306AsciiSpi sends. The emulator's spiTimeUs() gives its wire
+ * time.
+ */
+class EmulatorSpiBus : public I2CBusInterface
+{
+  public:
+    /**
+     * @brief Attach an emulator, the address of a transfer is ignored.
+     *
+     * @param[in] model The controller model.
+     */
+    explicit EmulatorSpiBus(SSD1306Emulator &model) : emulator(model)
+    {
+    }
+
+  protected:
+    /**
+     * @return true, SPI has no acknowledge.
+     */
+    bool transfer(const uint8_t *data, size_t len) override
+    {
+        size_t i = 0;
+        while (i < len)
+        {
+            uint8_t control = data[i++];
+            bool dc = control & 0X40;
+            size_t end = control & 0X80 ? i + 1 : len;
+            while (i < end && i < len)
+            {
+                emulator.spiWrite(dc, data[i++]);
+            }
+        }
+        return true;
+    }
+
+  private:
+    SSD1306Emulator &emulator;
+};
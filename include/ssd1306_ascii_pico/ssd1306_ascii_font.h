@@ -0,0 +1,496 @@
+#pragma once
+
+/**
+ * @file ssd1306_ascii_font.h
+ * @brief Font handle with metrics decoded once.
+ */
+
+#include "ssd1306_ascii_glyph_index.h"
+
+//------------------------------------------------------------------------------
+// Extended font tables start with FONT_EXT_MARK in place of the high byte of
+// the GLCD length field, which is never 0XFF in a GLCD font. FONT_WIDTH,
+// FONT_HEIGHT, FONT_FIRST_CHAR and FONT_CHAR_COUNT keep their GLCD meaning.
+/** First byte of an extended font table. */
+#define FONT_EXT_MARK 0XFF
+/** Index of the format of an extended font table. */
+#define FONT_EXT_FORMAT 1
+/** Index of the number of eight pixel rows of each character. */
+#define FONT_EXT_ROWS 6
+/** Index of the default letter-spacing in pixels. */
+#define FONT_EXT_SPACING 7
+/** Index of the width table, followed by a little endian offset of the data
+ *  of each character from the end of the offset table. */
+#define FONT_EXT_WIDTHS 8
+/** Index of the little endian character count of a sparse font, in place of
+ *  FONT_FIRST_CHAR and FONT_CHAR_COUNT. */
+#define FONT_EXT_GLYPHS 4
+/** Index of the number of code point ranges of a sparse font. */
+#define FONT_EXT_RANGE_COUNT 8
+/** Index of the ranges of a sparse font, followed by the width table. Each
+ *  range is the first code point, the count of code points and the index of
+ *  the first character, little endian 16 bit values sorted by code point. */
+#define FONT_EXT_RANGES 9
+/** Size of a sparse font range in bytes. */
+#define FONT_EXT_RANGE_SIZE 6
+
+// Values of Font::format().
+/** GLCD font, fixed width or Thiele. */
+#define FONT_FORMAT_GLCD 0
+/** Extended font, each row of a character is one page of display RAM. */
+#define FONT_FORMAT_PAGED 1
+/** Paged font covering a sorted list of code point ranges. */
+#define FONT_FORMAT_SPARSE 2
+/** Paged font with the data of each character compressed, see RleDecoder. */
+#define FONT_FORMAT_RLE 3
+//------------------------------------------------------------------------------
+/** Largest magnification factor, a column byte spreads to at most 64 bits. */
+#define MAG_MAX 8
+/**
+ * @struct MagSpread
+ * @brief Bit spreading tables for vertical magnification.
+ *
+ * nibble[f - 1][n] holds the four bits of n with each bit repeated f times.
+ */
+struct MagSpread
+{
+    uint32_t nibble[MAG_MAX][16]; ///< Spread nibbles for factors one to MAG_MAX.
+};
+/**
+ * @brief Build the vertical magnification tables.
+ *
+ * @return The tables, computed by the compiler.
+ */
+constexpr MagSpread makeMagSpread()
+{
+    MagSpread t{};
+    for (uint8_t f = 1; f <= MAG_MAX; f++)
+    {
+        for (uint8_t n = 0; n < 16; n++)
+        {
+            for (uint8_t i = 0; i < 4; i++)
+            {
+                if (n & (1 << i))
+                {
+                    t.nibble[f - 1][n] |= ((uint32_t(1) << f) - 1) << (i * f);
+                }
+            }
+        }
+    }
+    return t;
+}
+/** Vertical magnification tables. */
+static constexpr MagSpread magSpread = makeMagSpread();
+/**
+ * @brief Magnify a column byte vertically.
+ *
+ * @param[in] b Column byte.
+ * @param[in] f Vertical magnification factor, one to MAG_MAX.
+ * @param[in] m Page of the magnified byte, zero to f - 1.
+ * @return Page m of b with each bit repeated f times.
+ */
+constexpr uint8_t magSpreadPage(uint8_t b, uint8_t f, uint8_t m)
+{
+    const uint32_t *spread = magSpread.nibble[f - 1];
+    uint64_t v = spread[b & 0XF] | (uint64_t)spread[b >> 4] << (4 * f);
+    return v >> (8 * m);
+}
+/**
+ * @brief Read a little endian 16 bit value from a font table.
+ *
+ * @param[in] p Address of the low byte.
+ * @return The value.
+ */
+constexpr uint16_t readFontWord(const uint8_t *p)
+{
+    return readFontByte(p) | readFontByte(p + 1) << 8;
+}
+//------------------------------------------------------------------------------
+/**
+ * @struct RleDecoder
+ * @brief Streaming decoder of the characters of a FONT_FORMAT_RLE font.
+ *
+ * The rows of a character are compressed as one stream of codes:
+ *
+ * 0X00 - 0X7F: the next code + 1 bytes are copied.
+ *
+ * 0X80 - 0XBF: (code & 0X3F) + 1 zero bytes.
+ *
+ * 0XC0 - 0XFF: the next byte repeated (code & 0X3F) + 2 times.
+ */
+struct RleDecoder
+{
+    const uint8_t *p; ///< Next byte of the stream.
+    uint8_t n;        ///< Bytes left in the current code.
+    uint8_t b;        ///< Repeated byte.
+    bool literal;     ///< The current code copies bytes.
+    /**
+     * @brief Start decoding a character.
+     *
+     * @param[in] data The compressed character.
+     */
+    void begin(const uint8_t *data)
+    {
+        p = data;
+        n = 0;
+    }
+    /**
+     * @return The next byte of the character.
+     */
+    uint8_t next()
+    {
+        if (!n)
+        {
+            uint8_t code = readFontByte(p++);
+            literal = code < 0X80;
+            if (literal)
+            {
+                n = code + 1;
+            }
+            else if (code < 0XC0)
+            {
+                b = 0;
+                n = (code & 0X3F) + 1;
+            }
+            else
+            {
+                b = readFontByte(p++);
+                n = (code & 0X3F) + 2;
+            }
+        }
+        n--;
+        return literal ? readFontByte(p++) : b;
+    }
+};
+//------------------------------------------------------------------------------
+/**
+ * @class Font
+ * @brief A font table with its header decoded.
+ *
+ * A Font is created from a GLCDFONTDECL table or an extended font table,
+ * implicitly where a font pointer is expected, and holds the metrics and
+ * table pointers the rendering code needs so the header is read only once.
+ */
+class Font
+{
+  public:
+    /**
+     * @brief Create an empty font.
+     */
+    constexpr Font()
+    {
+    }
+    /**
+     * @brief Decode the header of a font table.
+     *
+     * @param[in] table Pointer to a font table, nullptr for no font.
+     * @param[in] index Glyph offsets of a GLCD font or nullptr.
+     */
+    constexpr Font(const uint8_t *table, const uint16_t *index = nullptr) : m_table(table)
+    {
+        if (!table)
+        {
+            return;
+        }
+        m_width = readFontByte(table + FONT_WIDTH);
+        m_height = readFontByte(table + FONT_HEIGHT);
+        m_first = readFontByte(table + FONT_FIRST_CHAR);
+        m_count = readFontByte(table + FONT_CHAR_COUNT);
+        if (readFontByte(table + FONT_LENGTH) == FONT_EXT_MARK)
+        {
+            m_format = readFontByte(table + FONT_EXT_FORMAT);
+            m_rows = readFontByte(table + FONT_EXT_ROWS);
+            m_spacing = readFontByte(table + FONT_EXT_SPACING);
+            m_widths = table + FONT_EXT_WIDTHS;
+            if (m_format == FONT_FORMAT_SPARSE)
+            {
+                m_count = readFontWord(table + FONT_EXT_GLYPHS);
+                m_nRanges = readFontByte(table + FONT_EXT_RANGE_COUNT);
+                m_ranges = table + FONT_EXT_RANGES;
+                m_first = m_nRanges ? readFontWord(m_ranges) : 0;
+                m_widths = m_ranges + FONT_EXT_RANGE_SIZE * m_nRanges;
+            }
+            m_data = m_widths + 3 * m_count;
+            return;
+        }
+        uint16_t type = (readFontByte(table + FONT_LENGTH) << 8) | readFontByte(table + FONT_LENGTH + 1);
+        m_rows = (m_height + 7) / 8;
+        // Type 1 is a fixed width font without padding pixels.
+        m_spacing = type == 1 ? 0 : 1;
+        m_index = index;
+        m_data = table + FONT_WIDTH_TABLE;
+        if (type > 1)
+        {
+            // Thiele font, the data follows the width table.
+            m_widths = m_data;
+            m_data += m_count;
+            if (m_height & 7)
+            {
+                m_thieleShift = 8 - (m_height & 7);
+            }
+        }
+    }
+    /**
+     * @brief Decode a font table with its compile time glyph offsets.
+     *
+     * @param[in] index Glyph offsets of the font, e.g. glyphIndex<Arial14>.
+     */
+    template <const uint8_t *Table>
+    constexpr Font(const GlyphOffsets<Table> &index) : Font(Table, index.offset)
+    {
+    }
+    /**
+     * @return true if the handle holds a font.
+     */
+    constexpr explicit operator bool() const
+    {
+        return m_table != nullptr;
+    }
+    /**
+     * @return Pointer to the font table.
+     */
+    constexpr const uint8_t *table() const
+    {
+        return m_table;
+    }
+    /**
+     * @return Table format, FONT_FORMAT_GLCD or an extended format.
+     */
+    constexpr uint8_t format() const
+    {
+        return m_format;
+    }
+    /**
+     * @return Maximum character width in pixels.
+     */
+    constexpr uint8_t width() const
+    {
+        return m_width;
+    }
+    /**
+     * @return Character height in pixels.
+     */
+    constexpr uint8_t height() const
+    {
+        return m_height;
+    }
+    /**
+     * @return Number of eight pixel rows of a character.
+     */
+    constexpr uint8_t rows() const
+    {
+        return m_rows;
+    }
+    /**
+     * @return The first character in the font.
+     */
+    constexpr uint16_t first() const
+    {
+        return m_first;
+    }
+    /**
+     * @return The count of characters in the font.
+     */
+    constexpr uint16_t count() const
+    {
+        return m_count;
+    }
+    /**
+     * @return true if characters have their own width.
+     */
+    constexpr bool proportional() const
+    {
+        return m_widths != nullptr;
+    }
+    /**
+     * @return Default letter-spacing in pixels.
+     */
+    constexpr uint8_t spacing() const
+    {
+        return m_spacing;
+    }
+    /**
+     * @return Right shift of the last row of a Thiele character.
+     */
+    constexpr uint8_t thieleShift() const
+    {
+        return m_thieleShift;
+    }
+    /**
+     * @return Pointer to the width table, nullptr for a fixed width font.
+     */
+    constexpr const uint8_t *widths() const
+    {
+        return m_widths;
+    }
+    /**
+     * @return Pointer to the character data.
+     */
+    constexpr const uint8_t *data() const
+    {
+        return m_data;
+    }
+    /**
+     * @return Glyph offsets of a GLCD font, nullptr if it has none.
+     */
+    constexpr const uint16_t *glyphOffsets() const
+    {
+        return m_index;
+    }
+    /**
+     * @brief Find the end of the font table.
+     *
+     * Extended fonts end with the character at the highest offset, which a
+     * compressed font decodes to find its last byte.
+     *
+     * @return Size of the font table in bytes.
+     */
+    size_t tableSize() const
+    {
+        if (!m_table)
+        {
+            return 0;
+        }
+        if (m_format == FONT_FORMAT_GLCD)
+        {
+            uint32_t columns = (uint32_t)m_width * m_count;
+            if (m_widths)
+            {
+                columns = 0;
+                for (uint16_t i = 0; i < m_count; i++)
+                {
+                    columns += readFontByte(m_widths + i);
+                }
+            }
+            return m_data - m_table + m_rows * columns;
+        }
+        uint16_t last = 0;
+        uint16_t offset = 0;
+        for (uint16_t i = 0; i < m_count; i++)
+        {
+            uint16_t o = readFontWord(m_widths + m_count + 2 * i);
+            if (o >= offset)
+            {
+                offset = o;
+                last = i;
+            }
+        }
+        const uint8_t *end = m_data + offset;
+        uint16_t n = m_rows * glyphWidth(last);
+        if (m_format != FONT_FORMAT_RLE || !m_count)
+        {
+            return end - m_table + (m_count ? n : 0);
+        }
+        RleDecoder rle;
+        rle.begin(end);
+        while (n--)
+        {
+            rle.next();
+        }
+        return rle.p - m_table;
+    }
+    /**
+     * @brief Find a character.
+     *
+     * Sparse fonts are searched with a binary search of their ranges.
+     *
+     * @param[in] c Character code.
+     * @return Index of the character in the font, -1 if it is missing.
+     */
+    constexpr int32_t index(uint16_t c) const
+    {
+        if (m_format != FONT_FORMAT_SPARSE)
+        {
+            return c >= m_first && c - m_first < m_count ? c - m_first : -1;
+        }
+        uint8_t lo = 0;
+        uint8_t hi = m_nRanges;
+        while (lo < hi)
+        {
+            uint8_t mid = (lo + hi) / 2;
+            const uint8_t *range = m_ranges + FONT_EXT_RANGE_SIZE * mid;
+            uint16_t first = readFontWord(range);
+            if (c < first)
+            {
+                hi = mid;
+            }
+            else if (c - first >= readFontWord(range + 2))
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                return readFontWord(range + 4) + c - first;
+            }
+        }
+        return -1;
+    }
+    /**
+     * @param[in] c Character code.
+     * @return true if the font has the character.
+     */
+    constexpr bool contains(uint16_t c) const
+    {
+        return index(c) >= 0;
+    }
+    /**
+     * @param[in] c Character code.
+     * @return Width of the character in pixels, zero if it is not in the font.
+     */
+    constexpr uint8_t charWidth(uint16_t c) const
+    {
+        int32_t i = index(c);
+        return i < 0 ? 0 : glyphWidth(i);
+    }
+    /**
+     * @param[in] i Character index, see index().
+     * @return Width of the character in pixels.
+     */
+    constexpr uint8_t glyphWidth(uint16_t i) const
+    {
+        return m_widths ? readFontByte(m_widths + i) : m_width;
+    }
+    /**
+     * @brief Locate the data of a character.
+     *
+     * @param[in] i Character index, see index().
+     * @return Pointer to rows() rows of the character's width bytes.
+     */
+    constexpr const uint8_t *glyph(uint16_t i) const
+    {
+        if (m_format != FONT_FORMAT_GLCD)
+        {
+            return m_data + readFontWord(m_widths + m_count + 2 * i);
+        }
+        if (!m_widths)
+        {
+            return m_data + m_rows * m_width * i;
+        }
+        if (m_index)
+        {
+            return m_widths + m_index[i];
+        }
+        uint16_t offset = 0;
+        for (uint16_t k = 0; k < i; k++)
+        {
+            offset += readFontByte(m_widths + k);
+        }
+        return m_data + m_rows * offset;
+    }
+
+  private:
+    const uint8_t *m_table = nullptr;  // Font table.
+    const uint16_t *m_index = nullptr; // Glyph offsets from the width table.
+    const uint8_t *m_widths = nullptr; // Width table.
+    const uint8_t *m_data = nullptr;   // First character's data.
+    const uint8_t *m_ranges = nullptr; // Code point ranges of a sparse font.
+    uint8_t m_format = FONT_FORMAT_GLCD;
+    uint8_t m_width = 0;
+    uint8_t m_height = 0;
+    uint8_t m_rows = 0;
+    uint16_t m_first = 0;
+    uint16_t m_count = 0;
+    uint8_t m_nRanges = 0;
+    uint8_t m_spacing = 1;
+    uint8_t m_thieleShift = 0;
+};
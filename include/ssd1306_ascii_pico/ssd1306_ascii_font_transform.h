@@ -0,0 +1,449 @@
+#pragma once
+
+/**
+ * @file ssd1306_ascii_font_transform.h
+ * @brief Compile time transformation of GLCD fonts into paged fonts.
+ *
+ * A paged font holds each character exactly as it is written to display
+ * RAM: Thiele characters are shifted and the optional magnification is
+ * applied, so write() copies the bytes without modifying them:
+ *
+ * @code
+ * display.setFont(pagedFont<Arial_bold_14>);
+ * display.setFont(pagedFont<lcdnums14x24, 3, 2>);
+ * @endcode
+ *
+ * A sparse font is a paged font with only the characters of a list of
+ * inclusive code point ranges:
+ *
+ * @code
+ * display.setFont(sparseFont<utf8font10x16, '0', '9', 'C', 'C', 0XB0, 0XB0>);
+ * @endcode
+ *
+ * A compressed font is a paged font with each character run length
+ * encoded, for large fonts with many blank columns:
+ *
+ * @code
+ * display.setFont(rleFont<CalBlk36>);
+ * @endcode
+ */
+
+#include "ssd1306_ascii_font.h"
+
+/**
+ * @struct FontTable
+ * @brief A font table generated by the compiler.
+ *
+ * @tparam N Size of the table in bytes.
+ */
+template <size_t N>
+struct FontTable
+{
+    /** The font table. */
+    uint8_t table[N];
+    /** @return The font. */
+    constexpr operator Font() const
+    {
+        return Font(table);
+    }
+};
+
+/**
+ * @brief Widest character of a font, which may exceed FONT_WIDTH.
+ *
+ * @tparam Src The font table.
+ * @return Width in pixels.
+ */
+template <const uint8_t *Src>
+constexpr uint8_t fontMaxWidth()
+{
+    Font font(Src);
+    uint8_t w = font.width();
+    for (uint16_t i = 0; i < font.count(); i++)
+    {
+        w = font.glyphWidth(i) > w ? font.glyphWidth(i) : w;
+    }
+    return w;
+}
+
+/**
+ * @brief Write a character of a font in paged form.
+ *
+ * @param[in] font The source font.
+ * @param[in] i Index of the character in the font.
+ * @param[in] x Horizontal magnification factor.
+ * @param[in] y Vertical magnification factor.
+ * @param[out] out Location of the paged character.
+ * @return Number of bytes written.
+ */
+constexpr uint16_t pageGlyph(const Font &font, uint16_t i, uint8_t x, uint8_t y, uint8_t *out)
+{
+    uint8_t w = font.glyphWidth(i);
+    const uint8_t *glyph = font.glyph(i);
+    uint8_t rows = font.rows();
+    uint16_t n = 0;
+    for (uint8_t r = 0; r < rows; r++)
+    {
+        for (uint8_t m = 0; m < y; m++)
+        {
+            for (uint8_t c = 0; c < w; c++)
+            {
+                uint8_t b = readFontByte(glyph + c + r * w);
+                if (font.thieleShift() && (r + 1) == rows)
+                {
+                    b >>= font.thieleShift();
+                }
+                b = magSpreadPage(b, y, m);
+                for (uint8_t k = 0; k < x; k++)
+                {
+                    out[n++] = b;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Size of the paged form of a font.
+ *
+ * @tparam Src The font table, declared with GLCDFONTDECL.
+ * @tparam X Horizontal magnification factor.
+ * @tparam Y Vertical magnification factor.
+ * @return Size of the table in bytes.
+ */
+template <const uint8_t *Src, uint8_t X, uint8_t Y>
+constexpr size_t pagedFontSize()
+{
+    Font font(Src);
+    size_t size = FONT_EXT_WIDTHS + 3 * font.count();
+    for (uint8_t i = 0; i < font.count(); i++)
+    {
+        size += Y * font.rows() * X * font.glyphWidth(i);
+    }
+    return size;
+}
+
+/**
+ * @brief Build the paged form of a font.
+ *
+ * @tparam Src The font table, declared with GLCDFONTDECL.
+ * @tparam X Horizontal magnification factor.
+ * @tparam Y Vertical magnification factor.
+ * @return The font table.
+ */
+template <const uint8_t *Src, uint8_t X, uint8_t Y>
+constexpr FontTable<pagedFontSize<Src, X, Y>()> makePagedFont()
+{
+    constexpr Font font(Src);
+    static_assert(font.format() == FONT_FORMAT_GLCD, "source must be a GLCD font");
+    static_assert(X >= 1 && X <= MAG_MAX && Y >= 1 && Y <= MAG_MAX, "bad magnification");
+    static_assert(X * fontMaxWidth<Src>() < 256 && Y * font.height() < 256, "magnified font too large");
+    static_assert(pagedFontSize<Src, X, Y>() - FONT_EXT_WIDTHS - 3 * font.count() <= 0XFFFF,
+                  "paged font too large");
+    FontTable<pagedFontSize<Src, X, Y>()> t{};
+    uint8_t *table = t.table;
+    uint8_t count = font.count();
+    uint8_t rows = font.rows();
+    table[FONT_LENGTH] = FONT_EXT_MARK;
+    table[FONT_EXT_FORMAT] = FONT_FORMAT_PAGED;
+    table[FONT_WIDTH] = X * font.width();
+    table[FONT_HEIGHT] = Y * font.height();
+    table[FONT_FIRST_CHAR] = font.first();
+    table[FONT_CHAR_COUNT] = count;
+    table[FONT_EXT_ROWS] = Y * rows;
+    table[FONT_EXT_SPACING] = X * font.spacing();
+    uint8_t *widths = table + FONT_EXT_WIDTHS;
+    uint8_t *data = widths + 3 * count;
+    uint16_t offset = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        widths[i] = X * font.glyphWidth(i);
+        widths[count + 2 * i] = offset & 0XFF;
+        widths[count + 2 * i + 1] = offset >> 8;
+        offset += pageGlyph(font, i, X, Y, data + offset);
+    }
+    return t;
+}
+
+/**
+ * @brief Paged form of a font, generated once per font at compile time.
+ *
+ * @tparam Src The font table, declared with GLCDFONTDECL.
+ * @tparam X Horizontal magnification factor, default one.
+ * @tparam Y Vertical magnification factor, default X.
+ */
+template <const uint8_t *Src, uint8_t X = 1, uint8_t Y = X>
+inline constexpr FontTable<pagedFontSize<Src, X, Y>()> pagedFont = makePagedFont<Src, X, Y>();
+
+/**
+ * @brief Check the ranges of a sparse font.
+ *
+ * @tparam Src The source font.
+ * @tparam Ranges Pairs of first and last code points.
+ * @return true if the ranges are sorted, disjoint and in the source font.
+ */
+template <const uint8_t *Src, uint16_t... Ranges>
+constexpr bool sparseRangesValid()
+{
+    Font font(Src);
+    constexpr uint16_t r[] = {Ranges...};
+    size_t n = sizeof...(Ranges);
+    if (n < 2 || n % 2 || n / 2 > 255)
+    {
+        return false;
+    }
+    for (size_t k = 0; k < n; k += 2)
+    {
+        if (r[k] > r[k + 1] || (k && r[k] <= r[k - 1]))
+        {
+            return false;
+        }
+        for (uint32_t c = r[k]; c <= r[k + 1]; c++)
+        {
+            if (!font.contains(c))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Size of a sparse font.
+ *
+ * @tparam Src The source font.
+ * @tparam Ranges Pairs of first and last code points.
+ * @return Size of the table in bytes.
+ */
+template <const uint8_t *Src, uint16_t... Ranges>
+constexpr size_t sparseFontSize()
+{
+    Font font(Src);
+    constexpr uint16_t r[] = {Ranges...};
+    size_t size = FONT_EXT_RANGES + FONT_EXT_RANGE_SIZE * (sizeof...(Ranges) / 2);
+    for (size_t k = 0; k + 1 < sizeof...(Ranges); k += 2)
+    {
+        for (uint32_t c = r[k]; c <= r[k + 1]; c++)
+        {
+            size += 3 + font.rows() * font.charWidth(c);
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Number of characters of a sparse font.
+ *
+ * @tparam Ranges Pairs of first and last code points.
+ * @return The sum of the range lengths.
+ */
+template <uint16_t... Ranges>
+constexpr uint32_t sparseGlyphCount()
+{
+    constexpr uint16_t r[] = {Ranges...};
+    uint32_t count = 0;
+    for (size_t k = 0; k + 1 < sizeof...(Ranges); k += 2)
+    {
+        count += r[k + 1] - r[k] + 1;
+    }
+    return count;
+}
+
+/**
+ * @brief Build a sparse font.
+ *
+ * @tparam Src The source font.
+ * @tparam Ranges Pairs of first and last code points.
+ * @return The font table.
+ */
+template <const uint8_t *Src, uint16_t... Ranges>
+constexpr FontTable<sparseFontSize<Src, Ranges...>()> makeSparseFont()
+{
+    static_assert(sparseRangesValid<Src, Ranges...>(),
+                  "ranges must be sorted pairs of characters in the font");
+    constexpr Font font(Src);
+    constexpr uint16_t r[] = {Ranges...};
+    constexpr uint8_t nRanges = sizeof...(Ranges) / 2;
+    constexpr uint32_t count = sparseGlyphCount<Ranges...>();
+    static_assert(count <= 0XFFFF, "sparse font has too many characters");
+    static_assert(sparseFontSize<Src, Ranges...>() - FONT_EXT_RANGES -
+                          FONT_EXT_RANGE_SIZE * nRanges - 3 * count <= 0XFFFF,
+                  "sparse font too large");
+    FontTable<sparseFontSize<Src, Ranges...>()> t{};
+    uint8_t *table = t.table;
+    table[FONT_LENGTH] = FONT_EXT_MARK;
+    table[FONT_EXT_FORMAT] = FONT_FORMAT_SPARSE;
+    table[FONT_WIDTH] = font.width();
+    table[FONT_HEIGHT] = font.height();
+    table[FONT_EXT_GLYPHS] = count & 0XFF;
+    table[FONT_EXT_GLYPHS + 1] = count >> 8;
+    table[FONT_EXT_ROWS] = font.rows();
+    table[FONT_EXT_SPACING] = font.spacing();
+    table[FONT_EXT_RANGE_COUNT] = nRanges;
+    uint8_t *widths = table + FONT_EXT_RANGES + FONT_EXT_RANGE_SIZE * nRanges;
+    uint8_t *data = widths + 3 * count;
+    uint16_t g = 0;
+    uint16_t offset = 0;
+    for (uint8_t k = 0; k < nRanges; k++)
+    {
+        uint8_t *range = table + FONT_EXT_RANGES + FONT_EXT_RANGE_SIZE * k;
+        uint16_t n = r[2 * k + 1] - r[2 * k] + 1;
+        range[0] = r[2 * k] & 0XFF;
+        range[1] = r[2 * k] >> 8;
+        range[2] = n & 0XFF;
+        range[3] = n >> 8;
+        range[4] = g & 0XFF;
+        range[5] = g >> 8;
+        for (uint32_t c = r[2 * k]; c <= r[2 * k + 1]; c++, g++)
+        {
+            uint16_t i = font.index(c);
+            widths[g] = font.glyphWidth(i);
+            widths[count + 2 * g] = offset & 0XFF;
+            widths[count + 2 * g + 1] = offset >> 8;
+            offset += pageGlyph(font, i, 1, 1, data + offset);
+        }
+    }
+    return t;
+}
+
+/**
+ * @brief Sparse font, generated once per font and ranges at compile time.
+ *
+ * @tparam Src The source font.
+ * @tparam Ranges Pairs of first and last code points, sorted and disjoint.
+ */
+template <const uint8_t *Src, uint16_t... Ranges>
+inline constexpr FontTable<sparseFontSize<Src, Ranges...>()> sparseFont = makeSparseFont<Src, Ranges...>();
+
+/**
+ * @brief Run length encode a character, see RleDecoder.
+ *
+ * @param[in] in The paged character.
+ * @param[in] n Size of the character in bytes.
+ * @param[out] out Location of the compressed character, nullptr to measure.
+ * @return Size of the compressed character in bytes.
+ */
+constexpr uint16_t rleEncode(const uint8_t *in, uint16_t n, uint8_t *out)
+{
+    uint16_t o = 0;
+    uint16_t i = 0;
+    while (i < n)
+    {
+        uint16_t run = 1;
+        while (i + run < n && in[i + run] == in[i] && run < (in[i] ? 65 : 64))
+        {
+            run++;
+        }
+        if (!in[i] || run > 2)
+        {
+            if (out)
+            {
+                out[o] = in[i] ? 0XC0 | (run - 2) : 0X80 | (run - 1);
+                if (in[i])
+                {
+                    out[o + 1] = in[i];
+                }
+            }
+            o += in[i] ? 2 : 1;
+            i += run;
+            continue;
+        }
+        // Copy bytes up to the next zero or repeated run.
+        uint16_t len = 0;
+        while (i + len < n && len < 128 && in[i + len] &&
+               !(i + len + 2 < n && in[i + len] == in[i + len + 1] && in[i + len] == in[i + len + 2]))
+        {
+            len++;
+        }
+        if (out)
+        {
+            out[o] = len - 1;
+            for (uint16_t k = 0; k < len; k++)
+            {
+                out[o + 1 + k] = in[i + k];
+            }
+        }
+        o += 1 + len;
+        i += len;
+    }
+    return o;
+}
+
+/**
+ * @brief Build the compressed form of a font, or measure it.
+ *
+ * @tparam Src The font table, declared with GLCDFONTDECL.
+ * @tparam X Horizontal magnification factor.
+ * @tparam Y Vertical magnification factor.
+ * @param[out] table Location of the font table, nullptr to measure.
+ * @return Size of the table in bytes.
+ */
+template <const uint8_t *Src, uint8_t X, uint8_t Y>
+constexpr size_t rleFontBuild(uint8_t *table)
+{
+    constexpr Font font(Src);
+    static_assert(font.format() == FONT_FORMAT_GLCD, "source must be a GLCD font");
+    static_assert(X >= 1 && X <= MAG_MAX && Y >= 1 && Y <= MAG_MAX, "bad magnification");
+    static_assert(X * fontMaxWidth<Src>() < 256 && Y * font.height() < 256, "magnified font too large");
+    uint8_t glyph[Y * font.rows() * X * fontMaxWidth<Src>()] = {};
+    uint8_t count = font.count();
+    if (table)
+    {
+        table[FONT_LENGTH] = FONT_EXT_MARK;
+        table[FONT_EXT_FORMAT] = FONT_FORMAT_RLE;
+        table[FONT_WIDTH] = X * font.width();
+        table[FONT_HEIGHT] = Y * font.height();
+        table[FONT_FIRST_CHAR] = font.first();
+        table[FONT_CHAR_COUNT] = count;
+        table[FONT_EXT_ROWS] = Y * font.rows();
+        table[FONT_EXT_SPACING] = X * font.spacing();
+    }
+    size_t offset = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint16_t n = pageGlyph(font, i, X, Y, glyph);
+        if (table)
+        {
+            uint8_t *widths = table + FONT_EXT_WIDTHS;
+            widths[i] = X * font.glyphWidth(i);
+            widths[count + 2 * i] = offset & 0XFF;
+            widths[count + 2 * i + 1] = offset >> 8;
+            offset += rleEncode(glyph, n, widths + 3 * count + offset);
+        }
+        else
+        {
+            offset += rleEncode(glyph, n, nullptr);
+        }
+    }
+    return FONT_EXT_WIDTHS + 3 * count + offset;
+}
+
+/**
+ * @brief Build the compressed form of a font.
+ *
+ * @tparam Src The font table, declared with GLCDFONTDECL.
+ * @tparam X Horizontal magnification factor.
+ * @tparam Y Vertical magnification factor.
+ * @return The font table.
+ */
+template <const uint8_t *Src, uint8_t X, uint8_t Y>
+constexpr FontTable<rleFontBuild<Src, X, Y>(nullptr)> makeRleFont()
+{
+    static_assert(rleFontBuild<Src, X, Y>(nullptr) - FONT_EXT_WIDTHS - 3 * Src[FONT_CHAR_COUNT] <= 0XFFFF,
+                  "compressed font too large");
+    FontTable<rleFontBuild<Src, X, Y>(nullptr)> t{};
+    rleFontBuild<Src, X, Y>(t.table);
+    return t;
+}
+
+/**
+ * @brief Compressed form of a font, generated once per font at compile time.
+ *
+ * @tparam Src The font table, declared with GLCDFONTDECL.
+ * @tparam X Horizontal magnification factor, default one.
+ * @tparam Y Vertical magnification factor, default X.
+ */
+template <const uint8_t *Src, uint8_t X = 1, uint8_t Y = X>
+inline constexpr FontTable<rleFontBuild<Src, X, Y>(nullptr)> rleFont = makeRleFont<Src, X, Y>();
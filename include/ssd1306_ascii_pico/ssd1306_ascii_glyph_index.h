@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * @file ssd1306_ascii_glyph_index.h
+ * @brief Compile time glyph offset tables.
+ *
+ * The data of a character in a proportional font follows the data of all
+ * previous characters, so finding it means summing the width table. A
+ * GlyphOffsets table holds the offset of every character, computed by the
+ * compiler and stored in flash.  The table carries its font, so it can not
+ * be paired with another one:
+ *
+ * @code
+ * display.setFont(glyphIndex<Arial14>);
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fonts/allFonts.h"
+
+/**
+ * @struct GlyphOffsets
+ * @brief Offset of each character's data in a font.
+ *
+ * @tparam Table The font table, declared with GLCDFONTDECL.
+ */
+template <const uint8_t *Table>
+struct GlyphOffsets
+{
+    /** The font table of the offsets. */
+    static constexpr const uint8_t *font = Table;
+    /** Offset from the start of the width table, one entry per character. */
+    uint16_t offset[Table[FONT_CHAR_COUNT] ? Table[FONT_CHAR_COUNT] : 1];
+};
+
+/**
+ * @brief Compute the glyph offsets of a font.
+ *
+ * @tparam Font The font table, declared with GLCDFONTDECL.
+ * @return The offset table.
+ */
+template <const uint8_t *Font>
+constexpr GlyphOffsets<Font> makeGlyphOffsets()
+{
+    GlyphOffsets<Font> index{};
+    uint8_t count = Font[FONT_CHAR_COUNT];
+    uint16_t rows = (Font[FONT_HEIGHT] + 7) / 8;
+    // Fixed width fonts have no width table.
+    bool fixed = ((Font[FONT_LENGTH] << 8) | Font[FONT_LENGTH + 1]) < 2;
+    uint16_t offset = fixed ? 0 : count;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        index.offset[i] = offset;
+        offset += rows * (fixed ? Font[FONT_WIDTH] : Font[FONT_WIDTH_TABLE + i]);
+    }
+    return index;
+}
+
+/**
+ * @brief Glyph offsets of a font, generated once per font at compile time.
+ *
+ * @tparam Font The font table, declared with GLCDFONTDECL.
+ */
+template <const uint8_t *Font>
+inline constexpr GlyphOffsets<Font> glyphIndex = makeGlyphOffsets<Font>();
@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @file ssd1306_ascii_hal.h
+ * @brief Hardware abstraction for GPIO, delays and time.
+ *
+ * The display classes only talk to the hardware through these functions
+ * and through a bus interface, e.g. I2CBusInterface. Define
+ * SSD1306_ASCII_HOST to build the library for a host computer, where GPIO
+ * writes are ignored and time comes from the standard library.
+ */
+
+#ifndef SSD1306_ASCII_HOST
+/** Build for a host computer instead of the Pico SDK. */
+#define SSD1306_ASCII_HOST 0
+#endif // SSD1306_ASCII_HOST
+
+#if SSD1306_ASCII_HOST
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#else // SSD1306_ASCII_HOST
+#include <pico/stdlib.h>
+#endif // SSD1306_ASCII_HOST
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Configure a pin as an output.
+ *
+ * @param[in] pin The pin number.
+ */
+inline void ssd1306_gpio_init_out(uint8_t pin)
+{
+#if SSD1306_ASCII_HOST
+    (void)pin;
+#else  // SSD1306_ASCII_HOST
+    gpio_init(pin);
+    gpio_set_dir(pin, true);
+#endif // SSD1306_ASCII_HOST
+}
+/**
+ * @brief Drive an output pin.
+ *
+ * @param[in] pin The pin number.
+ * @param[in] value The pin level.
+ */
+inline void ssd1306_gpio_put(uint8_t pin, bool value)
+{
+#if SSD1306_ASCII_HOST
+    (void)pin;
+    (void)value;
+#else  // SSD1306_ASCII_HOST
+    gpio_put(pin, value);
+#endif // SSD1306_ASCII_HOST
+}
+/**
+ * @brief Wait for a number of milliseconds.
+ *
+ * @param[in] ms The delay in milliseconds.
+ */
+inline void ssd1306_sleep_ms(uint32_t ms)
+{
+#if SSD1306_ASCII_HOST
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#else  // SSD1306_ASCII_HOST
+    sleep_ms(ms);
+#endif // SSD1306_ASCII_HOST
+}
+/**
+ * @return Microseconds since an arbitrary point in time.
+ */
+inline uint64_t ssd1306_time_us()
+{
+#if SSD1306_ASCII_HOST
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else  // SSD1306_ASCII_HOST
+    return time_us_64();
+#endif // SSD1306_ASCII_HOST
+}
@@ -2,10 +2,119 @@
 
 #include "SSD1306Ascii.h"
 
+#if !SSD1306_ASCII_HOST
 #include <hardware/i2c.h>
 #include <pico/binary_info.h>
+#endif // !SSD1306_ASCII_HOST
 
-class I2CBus
+/**
+ * @class I2CBusInterface
+ * @brief Write only I2C bus used by SSD1306AsciiI2C.
+ *
+ * Bytes written between beginTransmission() and endTransmission() are
+ * buffered and handed to transfer() as a single I2C transfer.
+ */
+class I2CBusInterface
+{
+  public:
+    virtual ~I2CBusInterface() = default;
+
+    /**
+     * @brief Send the buffered bytes as a single I2C transfer.
+     *
+     * @return true if the transfer was acknowledged by the device.  Buses
+     *         that send in the background return true once the transfer is
+     *         queued and report errors with their own counters.
+     */
+    bool endTransmission()
+    {
+        bool rtn = length == 0 || transfer(buffer, length);
+        transmitting = false;
+        length = 0;
+        return rtn;
+    }
+
+    /**
+     * @brief Wait until all transfers have been sent on the bus.
+     */
+    virtual void flush()
+    {
+        // Transfers are blocking, nothing to do
+    }
+
+    /**
+     * @return Number of bytes that can be queued without blocking,
+     *         zero for blocking buses.
+     */
+    virtual int availableForWrite()
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Start buffering a transfer to a device.
+     *
+     * @param[in] addr The I2C address of the device.
+     * @note A transfer still open for another device is sent first.
+     */
+    void beginTransmission(const uint8_t &addr)
+    {
+        if (transmitting)
+        {
+            endTransmission();
+        }
+        address = addr;
+        transmitting = true;
+    }
+
+    /**
+     * @brief Add a byte to the current transfer.
+     *
+     * @param[in] c The byte to send.
+     * @return one for success or zero if the buffer is full.
+     */
+    size_t write(const uint8_t &c)
+    {
+        if (length >= I2C_BUFFER_SIZE)
+        {
+            return 0;
+        }
+        buffer[length++] = c;
+        return 1;
+    }
+
+    /**
+     * @return true if a transfer to addr is open.
+     */
+    bool isTransmitting(const uint8_t &addr) const
+    {
+        return transmitting && address == addr;
+    }
+
+  protected:
+    /**
+     * @brief Send a complete transfer to the current address.
+     *
+     * @param[in] data The bytes to send.
+     * @param[in] len The number of bytes to send.
+     * @return true if the transfer was acknowledged by the device.
+     */
+    virtual bool transfer(const uint8_t *data, size_t len) = 0;
+
+    uint8_t address = 0x00;
+
+  private:
+    bool transmitting = false;
+    size_t length = 0;
+    uint8_t buffer[I2C_BUFFER_SIZE];
+};
+
+#if !SSD1306_ASCII_HOST
+/**
+ * @class I2CBus
+ * @brief I2C bus on one of the RP2040 I2C controllers.
+ */
+class I2CBus : public I2CBusInterface
 {
   public:
     I2CBus(const uint8_t &port_id, const unsigned char &sda_pin,
@@ -26,25 +135,15 @@ class I2CBus
         i2c_set_baudrate(port, speed);
     }
 
-    void endTransmission()
-    {
-        // Nothing to do
-    }
-
-    void beginTransmission(const uint8_t &addr)
-    {
-        address = addr;
-    }
-
-    void write(const uint8_t &c)
+  protected:
+    bool transfer(const uint8_t *data, size_t len) override
     {
-        i2c_write_blocking(port, address, &c, 1, false);
+        return i2c_write_blocking(port, address, data, len, false) >= 0;
     }
 
-  private:
-    uint8_t address = 0x00;
     i2c_inst_t *port = nullptr;
 };
+#endif // !SSD1306_ASCII_HOST
 
 /**
  * @class SSD1306AsciiI2C
@@ -58,7 +157,7 @@ class SSD1306AsciiI2C : public SSD1306Ascii
      *
      * @param[in] bus The I2C bus to be used.
      */
-    explicit SSD1306AsciiI2C(I2CBus &bus) : i2c_bus(bus)
+    explicit SSD1306AsciiI2C(I2CBusInterface &bus) : i2c_bus(bus)
     {
     }
     /**
@@ -88,22 +187,56 @@ class SSD1306AsciiI2C : public SSD1306Ascii
         begin(dev, i2cAddr);
     }
 
-  protected:
-    void writeDisplay(uint8_t b, uint8_t mode)
+    /**
+     * @brief Send the changed spans of the frame buffer and any buffered
+     *        command and display RAM bytes to the controller and wait until
+     *        the bus has sent them.
+     */
+    void flush() override
     {
+        sendFrameBuffer();
 #if OPTIMIZE_I2C
-        if (m_nData > 16 || (m_nData && mode == SSD1306_MODE_CMD))
+        if (m_nData && i2c_bus.isTransmitting(m_i2cAddr))
         {
             i2c_bus.endTransmission();
+        }
+        m_nData = 0;
+#endif // OPTIMIZE_I2C
+        i2c_bus.flush();
+    }
+
+    /**
+     * @return Number of bytes the bus can queue without blocking.
+     */
+    int availableForWrite() override
+    {
+        return i2c_bus.availableForWrite();
+    }
+
+  protected:
+    void writeDisplay(uint8_t b, uint8_t mode) override
+    {
+        bool cmd = mode == SSD1306_MODE_CMD || mode == SSD1306_MODE_CMD_BUF;
+#if OPTIMIZE_I2C
+        // Another device may have closed our transfer on a shared bus.
+        if (m_nData && (m_nData >= (I2C_BUFFER_SIZE - 1) || cmd != m_cmdData ||
+                        !i2c_bus.isTransmitting(m_i2cAddr)))
+        {
+            if (i2c_bus.isTransmitting(m_i2cAddr))
+            {
+                i2c_bus.endTransmission();
+            }
             m_nData = 0;
         }
         if (m_nData == 0)
         {
+            // Control byte 0X00 is followed by a stream of command bytes.
             i2c_bus.beginTransmission(m_i2cAddr);
-            i2c_bus.write(mode == SSD1306_MODE_CMD ? 0X00 : 0X40);
+            i2c_bus.write(cmd ? 0X00 : 0X40);
+            m_cmdData = cmd;
         }
         i2c_bus.write(b);
-        if (mode == SSD1306_MODE_RAM_BUF)
+        if (mode == SSD1306_MODE_RAM_BUF || mode == SSD1306_MODE_CMD_BUF)
         {
             m_nData++;
         }
@@ -114,16 +247,17 @@ class SSD1306AsciiI2C : public SSD1306Ascii
         }
 #else  // OPTIMIZE_I2C
         i2c_bus.beginTransmission(m_i2cAddr);
-        i2c_bus.write(mode == SSD1306_MODE_CMD ? 0X00 : 0X40);
+        i2c_bus.write(cmd ? 0X00 : 0X40);
         i2c_bus.write(b);
         i2c_bus.endTransmission();
 #endif // OPTIMIZE_I2C
     }
 
   protected:
-    I2CBus &i2c_bus;
+    I2CBusInterface &i2c_bus;
     uint8_t m_i2cAddr;
 #if OPTIMIZE_I2C
-    uint8_t m_nData;
+    uint16_t m_nData = 0;
+    bool m_cmdData = false; // Open transfer holds command bytes.
 #endif // OPTIMIZE_I2C
 };
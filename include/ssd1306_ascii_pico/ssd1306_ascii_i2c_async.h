@@ -0,0 +1,216 @@
+#pragma once
+
+#include "ssd1306_ascii_i2c.h"
+
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+/**
+ * @class I2CAsyncBus
+ * @brief I2C bus that queues transfers and sends them from the I2C interrupt.
+ *
+ * endTransmission() copies the transfer into a ring of I2C_QUEUE_SIZE
+ * entries and returns at once; it only blocks while the ring is full.
+ * The TX empty interrupt moves queued bytes to the controller FIFO.
+ * SSD1306AsciiI2C::flush() waits for the queue to drain and
+ * SSD1306AsciiI2C::availableForWrite() reports the free queue space.
+ *
+ * The interrupt runs on the core that created the bus.  A spin lock keeps
+ * it from moving entries while the other core starts sending.
+ */
+class I2CAsyncBus : public I2CBus
+{
+    static_assert((I2C_QUEUE_SIZE & (I2C_QUEUE_SIZE - 1)) == 0 && I2C_QUEUE_SIZE <= 0X8000,
+                  "I2C_QUEUE_SIZE must be a power of two");
+
+  public:
+    /**
+     * @brief Initialize the I2C bus and install its interrupt handler.
+     *
+     * @param[in] port_id The I2C controller, 0 or 1.
+     * @param[in] sda_pin The SDA pin.
+     * @param[in] scl_pin The SCL pin.
+     * @param[in] speed The I2C clock in Hz.
+     */
+    I2CAsyncBus(const uint8_t &port_id, const unsigned char &sda_pin,
+                const unsigned char &scl_pin, const unsigned long speed)
+        : I2CBus(port_id, sda_pin, scl_pin, speed)
+    {
+        uint index = i2c_hw_index(port);
+        i2c_hw_t *hw = i2c_get_hw(port);
+        instances[index] = this;
+        lock = spin_lock_instance(next_striped_spin_lock_num());
+        hw->intr_mask = 0;
+        hw->tx_tl = TX_FIFO_DEPTH / 2;
+        irq_set_exclusive_handler(index ? I2C1_IRQ : I2C0_IRQ, index ? irqHandler1 : irqHandler0);
+        irq_set_enabled(index ? I2C1_IRQ : I2C0_IRQ, true);
+    }
+
+    ~I2CAsyncBus()
+    {
+        flush();
+        i2c_get_hw(port)->intr_mask = 0;
+        irq_set_enabled(i2c_hw_index(port) ? I2C1_IRQ : I2C0_IRQ, false);
+    }
+
+    /**
+     * @return true while queued bytes remain to be sent.
+     */
+    bool busy() const
+    {
+        return head != tail || !between || !idle();
+    }
+
+    /**
+     * @brief Wait until the queue is empty and the bus is idle.
+     */
+    void flush() override
+    {
+        while (busy())
+        {
+            tight_loop_contents();
+        }
+    }
+
+    int availableForWrite() override
+    {
+        return I2C_QUEUE_SIZE - (uint16_t)(head - tail);
+    }
+
+    /**
+     * @return Number of transfers aborted by a NACK since the bus was created.
+     */
+    uint32_t abortCount() const
+    {
+        return aborts;
+    }
+
+  protected:
+    /**
+     * @brief Queue a transfer to the current address.
+     *
+     * @return true, errors are counted by abortCount().
+     */
+    bool transfer(const uint8_t *data, size_t len) override
+    {
+        if (address != queued_address)
+        {
+            push(ADDRESS_BIT | address);
+            queued_address = address;
+        }
+        for (size_t i = 0; i < len; i++)
+        {
+            push(i + 1 == len ? data[i] | I2C_IC_DATA_CMD_STOP_BITS : data[i]);
+        }
+        kick();
+        return true;
+    }
+
+  private:
+    // Queue entry that changes the target address instead of sending a byte.
+    static const uint16_t ADDRESS_BIT = 0X8000;
+    // Depth of the controller TX FIFO.
+    static const uint8_t TX_FIFO_DEPTH = 16;
+
+    void push(uint16_t w)
+    {
+        if ((uint16_t)(head - tail) >= I2C_QUEUE_SIZE)
+        {
+            kick();
+            while ((uint16_t)(head - tail) >= I2C_QUEUE_SIZE)
+            {
+                tight_loop_contents();
+            }
+        }
+        queue[head & (I2C_QUEUE_SIZE - 1)] = w;
+        head = head + 1;
+    }
+
+    // Run the service routine, from either core or the interrupt.
+    void kick()
+    {
+        uint32_t save = spin_lock_blocking(lock);
+        service();
+        spin_unlock(lock, save);
+    }
+
+    bool idle() const
+    {
+        uint32_t status = i2c_get_hw(port)->status;
+        return !(status & I2C_IC_STATUS_MST_ACTIVITY_BITS) && (status & I2C_IC_STATUS_TFE_BITS);
+    }
+
+    // Move queued entries to the controller, called with the lock held.
+    void service()
+    {
+        i2c_hw_t *hw = i2c_get_hw(port);
+        if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)
+        {
+            // The controller flushed its FIFO, drop the rest of the transfer.
+            (void)hw->clr_tx_abrt;
+            aborts = aborts + 1;
+            discard = !between;
+            between = true;
+        }
+        while (head != tail)
+        {
+            uint16_t w = queue[tail & (I2C_QUEUE_SIZE - 1)];
+            if (discard)
+            {
+                discard = !(w & I2C_IC_DATA_CMD_STOP_BITS);
+                tail = tail + 1;
+                continue;
+            }
+            if (between)
+            {
+                // A transfer starts once the previous one has sent its STOP.
+                (void)hw->clr_stop_det;
+                if (!idle())
+                {
+                    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+                    return;
+                }
+                if (w & ADDRESS_BIT)
+                {
+                    hw->enable = 0;
+                    hw->tar = w & 0X7F;
+                    hw->enable = 1;
+                    tail = tail + 1;
+                    continue;
+                }
+                between = false;
+            }
+            if (!(hw->status & I2C_IC_STATUS_TFNF_BITS))
+            {
+                hw->intr_mask = I2C_IC_INTR_MASK_M_TX_EMPTY_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+                return;
+            }
+            hw->data_cmd = w;
+            tail = tail + 1;
+            between = (w & I2C_IC_DATA_CMD_STOP_BITS) != 0;
+        }
+        hw->intr_mask = I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    }
+
+    static void irqHandler0()
+    {
+        instances[0]->kick();
+    }
+
+    static void irqHandler1()
+    {
+        instances[1]->kick();
+    }
+
+    static inline I2CAsyncBus *instances[2] = {nullptr, nullptr};
+
+    volatile uint16_t queue[I2C_QUEUE_SIZE];
+    volatile uint16_t head = 0;
+    volatile uint16_t tail = 0;
+    volatile bool between = true;
+    volatile bool discard = false;
+    volatile uint32_t aborts = 0;
+    spin_lock_t *lock;
+    // Address of the last queued transfer, an I2C address never has bit 7 set.
+    uint8_t queued_address = 0XFF;
+};
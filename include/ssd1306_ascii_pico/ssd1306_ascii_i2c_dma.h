@@ -0,0 +1,205 @@
+#pragma once
+
+#include "ssd1306_ascii_i2c.h"
+
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/regs/dreq.h>
+
+/**
+ * @class I2CDmaBus
+ * @brief I2C bus that sends each transfer from memory with a DMA channel.
+ *
+ * endTransmission() copies the buffered bytes to a command buffer and
+ * returns as soon as the DMA channel is started, so the CPU is free while
+ * the I2C controller sends the transfer. A new transfer waits for the
+ * previous one to complete.
+ *
+ * endTransmission() returns before the device has acknowledged the
+ * transfer. wait() reports the status of the last transfer and
+ * abortCount() counts the transfers aborted by a NACK.
+ */
+class I2CDmaBus : public I2CBus
+{
+  public:
+    /**
+     * @brief Initialize the I2C bus and claim a DMA channel.
+     *
+     * @param[in] port_id The I2C controller, 0 or 1.
+     * @param[in] sda_pin The SDA pin.
+     * @param[in] scl_pin The SCL pin.
+     * @param[in] speed The I2C clock in Hz.
+     */
+    I2CDmaBus(const uint8_t &port_id, const unsigned char &sda_pin,
+              const unsigned char &scl_pin, const unsigned long speed)
+        : I2CBus(port_id, sda_pin, scl_pin, speed)
+    {
+        dma_chan = dma_claim_unused_channel(true);
+        dma_channel_config c = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, i2c_hw_index(port) ? DREQ_I2C1_TX : DREQ_I2C0_TX);
+        dma_channel_configure(dma_chan, &c, &i2c_get_hw(port)->data_cmd, words, 0, false);
+    }
+
+    ~I2CDmaBus()
+    {
+        flush();
+        setCallback(nullptr);
+        dma_channel_unclaim(dma_chan);
+    }
+
+    /**
+     * @return true while a transfer is in progress.
+     */
+    bool busy()
+    {
+        if (pending && !callback)
+        {
+            poll();
+        }
+        return pending;
+    }
+
+    /**
+     * @brief Wait until the last transfer is complete.
+     *
+     * @return true if the last transfer was acknowledged by the device.
+     */
+    bool wait()
+    {
+        while (busy())
+        {
+            tight_loop_contents();
+        }
+        return !aborted;
+    }
+
+    void flush() override
+    {
+        wait();
+    }
+
+    /**
+     * @return Number of transfers aborted by a NACK since the bus was created.
+     */
+    uint32_t abortCount() const
+    {
+        return aborts;
+    }
+
+    /**
+     * @brief Set a function called from the I2C interrupt when a transfer
+     *        is complete.
+     *
+     * @param[in] cb The completion callback, nullptr to poll with busy().
+     * @param[in] ctx Argument passed to the callback.
+     */
+    void setCallback(void (*cb)(void *ctx), void *ctx = nullptr)
+    {
+        wait();
+        i2c_hw_t *hw = i2c_get_hw(port);
+        uint irq = i2c_hw_index(port) ? I2C1_IRQ : I2C0_IRQ;
+        callback = cb;
+        callback_ctx = ctx;
+        if (cb)
+        {
+            instances[i2c_hw_index(port)] = this;
+            irq_set_exclusive_handler(irq, i2c_hw_index(port) ? irqHandler1 : irqHandler0);
+            hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+            irq_set_enabled(irq, true);
+        }
+        else
+        {
+            hw->intr_mask = 0;
+            irq_set_enabled(irq, false);
+        }
+    }
+
+  protected:
+    /**
+     * @brief Start a DMA transfer to the current address.
+     *
+     * @return true, the transfer is pending. wait() reports its status and
+     *         errors are counted by abortCount().
+     */
+    bool transfer(const uint8_t *data, size_t len) override
+    {
+        wait();
+        i2c_hw_t *hw = i2c_get_hw(port);
+        hw->enable = 0;
+        hw->tar = address;
+        hw->enable = 1;
+        for (size_t i = 0; i < len; i++)
+        {
+            words[i] = data[i];
+        }
+        words[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+        (void)hw->clr_stop_det;
+        (void)hw->clr_tx_abrt;
+        aborted = false;
+        pending = true;
+        dma_channel_transfer_from_buffer_now(dma_chan, words, len);
+        return true;
+    }
+
+  private:
+    // Check the controller for the end of the current transfer.
+    void poll()
+    {
+        i2c_hw_t *hw = i2c_get_hw(port);
+        uint32_t raw = hw->raw_intr_stat;
+        if (raw & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)
+        {
+            // The controller flushes the TX FIFO, stop feeding it.
+            dma_channel_abort(dma_chan);
+            (void)hw->clr_tx_abrt;
+            aborted = true;
+            aborts = aborts + 1;
+        }
+        else if (dma_channel_is_busy(dma_chan) || !(raw & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS))
+        {
+            return;
+        }
+        (void)hw->clr_stop_det;
+        pending = false;
+    }
+
+    void onIrq()
+    {
+        if (!pending)
+        {
+            // Late STOP condition after an aborted transfer.
+            i2c_hw_t *hw = i2c_get_hw(port);
+            (void)hw->clr_stop_det;
+            (void)hw->clr_tx_abrt;
+            return;
+        }
+        poll();
+        if (!pending && callback)
+        {
+            callback(callback_ctx);
+        }
+    }
+
+    static void irqHandler0()
+    {
+        instances[0]->onIrq();
+    }
+
+    static void irqHandler1()
+    {
+        instances[1]->onIrq();
+    }
+
+    static inline I2CDmaBus *instances[2] = {nullptr, nullptr};
+
+    uint dma_chan;
+    volatile bool pending = false;
+    volatile bool aborted = false;
+    volatile uint32_t aborts = 0;
+    void (*callback)(void *) = nullptr;
+    void *callback_ctx = nullptr;
+    uint16_t words[I2C_BUFFER_SIZE];
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ssd1306_ascii_i2c.h"
+
+#include <vector>
+
+/**
+ * @class MockI2CBus
+ * @brief I2C bus that records transfers instead of sending them.
+ *
+ * Use it on the host, see SSD1306_ASCII_HOST, to count the bytes a
+ * rendering path puts on the wire or to feed the recorded stream to a
+ * display model.
+ */
+class MockI2CBus : public I2CBusInterface
+{
+  public:
+    /**
+     * @struct Transfer
+     * @brief One recorded I2C transfer.
+     */
+    struct Transfer
+    {
+        uint8_t address;           ///< 7-bit device address.
+        std::vector<uint8_t> data; ///< Bytes after the address byte.
+    };
+
+    /**
+     * @brief Create a mock bus.
+     *
+     * @param[in] keep_log Keep a copy of each transfer, counters only if false.
+     */
+    explicit MockI2CBus(bool keep_log = true) : keep(keep_log)
+    {
+    }
+
+    /**
+     * @return The recorded transfers.
+     */
+    const std::vector<Transfer> &transfers() const
+    {
+        return log;
+    }
+
+    /**
+     * @return Number of transfers since the last reset().
+     */
+    uint32_t transferCount() const
+    {
+        return count;
+    }
+
+    /**
+     * @return Number of bytes, address bytes included, since the last reset().
+     */
+    uint32_t byteCount() const
+    {
+        return bytes;
+    }
+
+    /**
+     * @brief Time the recorded transfers take on a real bus.
+     *
+     * Each byte takes nine clocks with its ACK bit and each transfer adds
+     * one clock for the START and one for the STOP condition.
+     *
+     * @param[in] speed The I2C clock in Hz.
+     * @return The wire time in microseconds.
+     */
+    double wireTimeUs(unsigned long speed) const
+    {
+        return (9.0 * bytes + 2.0 * count) * 1e6 / speed;
+    }
+
+    /**
+     * @brief Forget the recorded transfers and clear the counters.
+     */
+    void reset()
+    {
+        log.clear();
+        count = 0;
+        bytes = 0;
+    }
+
+  protected:
+    bool transfer(const uint8_t *data, size_t len) override
+    {
+        count++;
+        bytes += len + 1;
+        if (keep)
+        {
+            log.push_back({address, std::vector<uint8_t>(data, data + len)});
+        }
+        return true;
+    }
+
+  private:
+    bool keep;
+    uint32_t count = 0;
+    uint32_t bytes = 0;
+    std::vector<Transfer> log;
+};
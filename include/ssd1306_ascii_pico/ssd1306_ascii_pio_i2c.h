@@ -0,0 +1,257 @@
+#pragma once
+
+#include "ssd1306_ascii_i2c.h"
+
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/pio.h>
+
+//------------------------------------------------------------------------------
+// Write only I2C master program, assembled from:
+//
+// .program ssd1306_i2c_write
+// .side_set 1 opt pindirs
+//
+// ; SDA is the OUT, SET and JMP pin, SCL is the side-set pin. Both output
+// ; enables are inverted so pindir 1 releases a line and pindir 0 pulls it
+// ; low. Each TX FIFO word holds one byte in bits 31:24 and a last byte
+// ; flag in bit 23, which is what a 16-bit DMA write of
+// ; (byte << 8 | last << 7) replicated on both halves of the bus gives.
+// ; Each bit takes 8 cycles.
+//
+// public start:
+//     pull block                  ; wait for the first byte of a transfer
+//     set pindirs, 0       [3]    ; START: SDA low while SCL is high
+// byte:
+//     set y, 7      side 0 [1]
+// bitloop:
+//     out pindirs, 1 side 0 [1]   ; data bit on SDA while SCL is low
+//     nop           side 1 [3]
+//     jmp y-- bitloop side 0 [1]
+//     set pindirs, 1 side 0 [1]   ; release SDA for the ACK bit
+//     nop           side 1 [1]
+//     jmp pin nack  side 1 [1]    ; SDA high is a NACK
+//     out x, 1      side 0 [1]    ; last byte flag
+//     jmp !x next
+// stop:
+//     set pindirs, 0 side 0 [1]
+//     nop           side 1 [3]
+//     set pindirs, 1       [3]    ; STOP: SDA high while SCL is high
+//     irq nowait 4 rel            ; transfer done
+//     jmp start
+// next:
+//     pull block    side 0
+//     jmp byte
+// nack:
+//     irq wait 0 rel side 0       ; stall until the CPU drops the transfer
+//     jmp stop
+//------------------------------------------------------------------------------
+/** Entry point of the PIO I2C program. */
+#define SSD1306_PIO_I2C_START 0
+/** Number of PIO cycles per I2C bit. */
+#define SSD1306_PIO_I2C_CYCLES 8
+
+static const uint16_t ssd1306_pio_i2c_instructions[] = {
+    0x80a0, //  0: pull   block
+    0xe380, //  1: set    pindirs, 0             [3]
+    0xf147, //  2: set    y, 7            side 0 [1]
+    0x7181, //  3: out    pindirs, 1      side 0 [1]
+    0xbb42, //  4: nop                    side 1 [3]
+    0x1183, //  5: jmp    y--, 3          side 0 [1]
+    0xf181, //  6: set    pindirs, 1      side 0 [1]
+    0xb942, //  7: nop                    side 1 [1]
+    0x19d2, //  8: jmp    pin, 18         side 1 [1]
+    0x7121, //  9: out    x, 1            side 0 [1]
+    0x0030, // 10: jmp    !x, 16
+    0xf180, // 11: set    pindirs, 0      side 0 [1]
+    0xbb42, // 12: nop                    side 1 [3]
+    0xe381, // 13: set    pindirs, 1             [3]
+    0xc014, // 14: irq    nowait 4 rel
+    0x0000, // 15: jmp    0
+    0x90a0, // 16: pull   block           side 0
+    0x0002, // 17: jmp    2
+    0xd030, // 18: irq    wait 0 rel      side 0
+    0x000b, // 19: jmp    11
+};
+
+static const pio_program_t ssd1306_pio_i2c_program = {
+    ssd1306_pio_i2c_instructions,
+    sizeof(ssd1306_pio_i2c_instructions) / sizeof(ssd1306_pio_i2c_instructions[0]),
+    -1,
+};
+
+/**
+ * @class PioI2CBus
+ * @brief Write only I2C bus run by a PIO state machine and fed by DMA.
+ *
+ * Use it when both I2C controllers are taken or to run the SSD1306 above
+ * 400 kHz, e.g. 1 MHz Fast-mode Plus. Each byte is checked for an ACK and a
+ * NACK aborts the transfer with a STOP condition. Clock stretching is not
+ * supported.
+ *
+ * endTransmission() returns before the device has acknowledged the
+ * transfer. wait() reports the status of the last transfer and
+ * abortCount() counts the transfers aborted by a NACK.
+ */
+class PioI2CBus : public I2CBusInterface
+{
+  public:
+    /**
+     * @brief Load the program and start a state machine on the bus pins.
+     *
+     * @param[in] pio_inst The PIO block, pio0 or pio1.
+     * @param[in] sda_pin The SDA pin.
+     * @param[in] scl_pin The SCL pin.
+     * @param[in] speed The I2C clock in Hz.
+     */
+    PioI2CBus(PIO pio_inst, const unsigned char &sda_pin, const unsigned char &scl_pin,
+              const unsigned long speed)
+        : pio(pio_inst)
+    {
+        uint index = pio_get_index(pio);
+        if (program_offset[index] < 0)
+        {
+            program_offset[index] = pio_add_program(pio, &ssd1306_pio_i2c_program);
+        }
+        offset = program_offset[index];
+        sm = pio_claim_unused_sm(pio, true);
+
+        uint32_t pins = (1u << sda_pin) | (1u << scl_pin);
+        pio_sm_set_pins_with_mask(pio, sm, 0, pins);
+        pio_sm_set_pindirs_with_mask(pio, sm, pins, pins);
+        gpio_pull_up(sda_pin);
+        gpio_pull_up(scl_pin);
+        pio_gpio_init(pio, sda_pin);
+        gpio_set_oeover(sda_pin, GPIO_OVERRIDE_INVERT);
+        pio_gpio_init(pio, scl_pin);
+        gpio_set_oeover(scl_pin, GPIO_OVERRIDE_INVERT);
+
+        pio_sm_config c = pio_get_default_sm_config();
+        sm_config_set_wrap(&c, offset, offset + ssd1306_pio_i2c_program.length - 1);
+        sm_config_set_sideset(&c, 2, true, true);
+        sm_config_set_out_pins(&c, sda_pin, 1);
+        sm_config_set_set_pins(&c, sda_pin, 1);
+        sm_config_set_sideset_pins(&c, scl_pin);
+        sm_config_set_jmp_pin(&c, sda_pin);
+        sm_config_set_out_shift(&c, false, false, 32);
+        sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+        sm_config_set_clkdiv(&c, clockDivider(speed));
+        pio_sm_init(pio, sm, offset + SSD1306_PIO_I2C_START, &c);
+        pio_sm_set_enabled(pio, sm, true);
+
+        dma_chan = dma_claim_unused_channel(true);
+        dma_channel_config d = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&d, DMA_SIZE_16);
+        channel_config_set_read_increment(&d, true);
+        channel_config_set_write_increment(&d, false);
+        channel_config_set_dreq(&d, pio_get_dreq(pio, sm, true));
+        dma_channel_configure(dma_chan, &d, &pio->txf[sm], words, 0, false);
+    }
+
+    ~PioI2CBus()
+    {
+        flush();
+        dma_channel_unclaim(dma_chan);
+        pio_sm_set_enabled(pio, sm, false);
+        pio_sm_unclaim(pio, sm);
+    }
+
+    void setClock(const long &speed)
+    {
+        flush();
+        pio_sm_set_clkdiv(pio, sm, clockDivider(speed));
+    }
+
+    /**
+     * @return true while a transfer is in progress.
+     */
+    bool busy()
+    {
+        if (!pending)
+        {
+            return false;
+        }
+        if (pio_interrupt_get(pio, sm))
+        {
+            // NACK: drop the rest of the transfer and let the SM send STOP.
+            dma_channel_abort(dma_chan);
+            pio_sm_clear_fifos(pio, sm);
+            aborted = true;
+            aborts = aborts + 1;
+            pio_interrupt_clear(pio, sm);
+        }
+        if (!pio_interrupt_get(pio, 4 + sm))
+        {
+            return true;
+        }
+        pending = false;
+        return false;
+    }
+
+    /**
+     * @brief Wait until the last transfer is complete.
+     *
+     * @return true if the last transfer was acknowledged by the device.
+     */
+    bool wait()
+    {
+        while (busy())
+        {
+            tight_loop_contents();
+        }
+        return !aborted;
+    }
+
+    void flush() override
+    {
+        wait();
+    }
+
+    /**
+     * @return Number of transfers aborted by a NACK since the bus was created.
+     */
+    uint32_t abortCount() const
+    {
+        return aborts;
+    }
+
+  protected:
+    /**
+     * @brief Start a DMA transfer to the current address.
+     *
+     * @return true, the transfer is pending. wait() reports its status and
+     *         errors are counted by abortCount().
+     */
+    bool transfer(const uint8_t *data, size_t len) override
+    {
+        wait();
+        words[0] = (address << 1) << 8;
+        for (size_t i = 0; i < len; i++)
+        {
+            words[i + 1] = data[i] << 8;
+        }
+        words[len] |= 0X80;
+        pio_interrupt_clear(pio, 4 + sm);
+        aborted = false;
+        pending = true;
+        dma_channel_transfer_from_buffer_now(dma_chan, words, len + 1);
+        return true;
+    }
+
+  private:
+    static float clockDivider(unsigned long speed)
+    {
+        return (float)clock_get_hz(clk_sys) / (SSD1306_PIO_I2C_CYCLES * speed);
+    }
+
+    static inline int program_offset[2] = {-1, -1};
+
+    PIO pio;
+    uint sm;
+    uint offset;
+    uint dma_chan;
+    bool pending = false;
+    bool aborted = false;
+    uint32_t aborts = 0;
+    uint16_t words[I2C_BUFFER_SIZE + 1];
+};
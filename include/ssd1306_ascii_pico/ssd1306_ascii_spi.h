@@ -0,0 +1,240 @@
+#pragma once
+
+#include "SSD1306Ascii.h"
+
+#include <hardware/dma.h>
+#include <hardware/regs/dreq.h>
+#include <hardware/spi.h>
+#include <pico/binary_info.h>
+
+/**
+ * @class SPIBus
+ * @brief Write only SPI bus with DMA transfers.
+ *
+ * Bytes are collected in one of two buffers. send() starts a DMA transfer
+ * of the filled buffer and returns while the next bytes are collected in
+ * the other buffer.
+ */
+class SPIBus
+{
+  public:
+    /**
+     * @brief Initialize the SPI bus.
+     *
+     * @param[in] port_id The SPI controller, 0 or 1.
+     * @param[in] sck_pin The SCK pin.
+     * @param[in] mosi_pin The MOSI (TX) pin.
+     * @param[in] speed The SPI clock in Hz. The SSD1306 accepts up to 10 MHz.
+     */
+    SPIBus(const uint8_t &port_id, const unsigned char &sck_pin,
+           const unsigned char &mosi_pin, const unsigned long speed)
+    {
+        port = port_id == 0 ? spi0 : spi1;
+        spi_init(port, speed);
+        gpio_set_function(sck_pin, GPIO_FUNC_SPI);
+        gpio_set_function(mosi_pin, GPIO_FUNC_SPI);
+        // Make the SPI pins available to picotool
+        bi_decl(bi_2pins_with_func(mosi_pin, sck_pin, GPIO_FUNC_SPI));
+
+        dma_chan = dma_claim_unused_channel(true);
+        dma_channel_config c = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, spi_get_index(port) ? DREQ_SPI1_TX : DREQ_SPI0_TX);
+        dma_channel_configure(dma_chan, &c, &spi_get_hw(port)->dr, buffer[0], 0, false);
+    }
+
+    ~SPIBus()
+    {
+        flush();
+        dma_channel_unclaim(dma_chan);
+    }
+
+    void setClock(const long &speed)
+    {
+        flush();
+        spi_set_baudrate(port, speed);
+    }
+
+    /**
+     * @brief Select the device that receives the next bytes.
+     *
+     * @param[in] cs_pin The chip select pin of the device, active low.
+     * @note Bytes buffered for the previous device are sent first.
+     */
+    void select(const uint8_t &cs_pin)
+    {
+        if (cs_pin == cs)
+        {
+            return;
+        }
+        flush();
+        if (cs != NO_CS)
+        {
+            gpio_put(cs, 1);
+        }
+        cs = cs_pin;
+        gpio_put(cs, 0);
+    }
+
+    /**
+     * @brief Add a byte to the transmit buffer.
+     *
+     * @param[in] c The byte to send.
+     * @return one for success.
+     */
+    size_t write(const uint8_t &c)
+    {
+        if (length >= SPI_BUFFER_SIZE)
+        {
+            send();
+        }
+        buffer[current][length++] = c;
+        return 1;
+    }
+
+    /**
+     * @brief Start sending the buffered bytes.
+     *
+     * Short transfers are written directly to the SPI FIFO, longer ones are
+     * sent by DMA while the caller fills the other buffer.
+     */
+    void send()
+    {
+        if (!length)
+        {
+            return;
+        }
+        dma_channel_wait_for_finish_blocking(dma_chan);
+        if (length < SPI_DMA_MIN)
+        {
+            spi_write_blocking(port, buffer[current], length);
+        }
+        else
+        {
+            dma_channel_transfer_from_buffer_now(dma_chan, buffer[current], length);
+            current ^= 1;
+        }
+        length = 0;
+    }
+
+    /**
+     * @return true while bytes are being sent.
+     */
+    bool busy() const
+    {
+        return dma_channel_is_busy(dma_chan) || spi_is_busy(port);
+    }
+
+    /**
+     * @brief Send the buffered bytes and wait until they are on the wire.
+     */
+    void flush()
+    {
+        send();
+        dma_channel_wait_for_finish_blocking(dma_chan);
+        while (spi_is_busy(port))
+        {
+            tight_loop_contents();
+        }
+        // Discard the bytes clocked in while sending.
+        while (spi_is_readable(port))
+        {
+            (void)spi_get_hw(port)->dr;
+        }
+        spi_get_hw(port)->icr = SPI_SSPICR_RORIC_BITS;
+    }
+
+  private:
+    static const uint8_t NO_CS = 0XFF;
+    spi_inst_t *port = nullptr;
+    uint dma_chan;
+    uint8_t cs = NO_CS;
+    uint8_t current = 0;
+    size_t length = 0;
+    uint8_t buffer[2][SPI_BUFFER_SIZE];
+};
+
+/**
+ * @class SSD1306AsciiSpi
+ * @brief Class for 4-wire SPI displays.
+ */
+class SSD1306AsciiSpi : public SSD1306Ascii
+{
+  public:
+    /**
+     * @brief Initialize object on specific SPI bus.
+     *
+     * @param[in] bus The SPI bus to be used.
+     */
+    explicit SSD1306AsciiSpi(SPIBus &bus) : spi_bus(bus)
+    {
+    }
+    /**
+     * @brief Initialize the display controller.
+     *
+     * @param[in] dev A device initialization structure.
+     * @param[in] cs The display controller chip select pin.
+     * @param[in] dc The display controller data/command pin.
+     */
+    void begin(const DevType *dev, uint8_t cs, uint8_t dc)
+    {
+        m_cs = cs;
+        m_dc = dc;
+        ssd1306_gpio_init_out(m_cs);
+        ssd1306_gpio_put(m_cs, 1);
+        ssd1306_gpio_init_out(m_dc);
+        ssd1306_gpio_put(m_dc, 0);
+        m_dcData = false;
+        init(dev);
+    }
+    /**
+     * @brief Initialize the display controller.
+     *
+     * @param[in] dev A device initialization structure.
+     * @param[in] cs The display controller chip select pin.
+     * @param[in] dc The display controller data/command pin.
+     * @param[in] rst The display controller reset pin.
+     */
+    void begin(const DevType *dev, uint8_t cs, uint8_t dc, uint8_t rst)
+    {
+        oledReset(rst);
+        begin(dev, cs, dc);
+    }
+
+    /**
+     * @brief Send the changed spans of the frame buffer and any buffered
+     *        bytes to the controller and wait until the bus has sent them.
+     */
+    void flush() override
+    {
+        sendFrameBuffer();
+        spi_bus.flush();
+    }
+
+  protected:
+    void writeDisplay(uint8_t b, uint8_t mode) override
+    {
+        bool data = mode == SSD1306_MODE_RAM || mode == SSD1306_MODE_RAM_BUF;
+        spi_bus.select(m_cs);
+        if (data != m_dcData)
+        {
+            // D/C is sampled with the last bit of each byte.
+            spi_bus.flush();
+            ssd1306_gpio_put(m_dc, data);
+            m_dcData = data;
+        }
+        spi_bus.write(b);
+        if (mode == SSD1306_MODE_CMD || mode == SSD1306_MODE_RAM)
+        {
+            spi_bus.send();
+        }
+    }
+
+  protected:
+    SPIBus &spi_bus;
+    uint8_t m_cs;
+    uint8_t m_dc;
+    bool m_dcData = false;
+};
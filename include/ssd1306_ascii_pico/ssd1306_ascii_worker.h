@@ -0,0 +1,419 @@
+#pragma once
+
+#include "SSD1306Ascii.h"
+
+#include <atomic>
+#include <hardware/sync.h>
+#include <pico/multicore.h>
+
+/**
+ * @struct DisplayOp
+ * @brief Drawing operation posted to an SSD1306AsciiWorker.
+ */
+struct DisplayOp
+{
+    uint8_t type;                ///< Operation code.
+    uint8_t arg[4];              ///< Column, row or clear region.
+    const void *ptr;             ///< Font, ticker state or callback.
+    void *ctx;                   ///< Callback argument.
+    char text[WORKER_TEXT_DIM];  ///< Text to print, not null terminated if full.
+};
+
+/**
+ * @class SSD1306AsciiWorker
+ * @brief Run the rendering and bus I/O of a display on core 1.
+ *
+ * Core 0 posts operations into a single producer, single consumer lock free
+ * ring of WORKER_QUEUE_DIM entries and never waits: an operation that does
+ * not fit is dropped and counted by droppedOps(). Core 1 takes operations
+ * from the ring and executes them on the display. Text is copied into the
+ * ring; fonts, font chains, arenas and ticker states are passed by pointer
+ * and must stay valid until the operation has run. Settings without an
+ * operation of their own can be changed with call().
+ */
+class SSD1306AsciiWorker
+{
+    static_assert((WORKER_QUEUE_DIM & (WORKER_QUEUE_DIM - 1)) == 0 && WORKER_QUEUE_DIM <= 0X8000,
+                  "WORKER_QUEUE_DIM must be a power of two");
+
+  public:
+    /**
+     * @brief Create a worker for an initialized display.
+     *
+     * @param[in] display The display driven by core 1.
+     */
+    explicit SSD1306AsciiWorker(SSD1306Ascii &display) : m_display(display)
+    {
+    }
+    /**
+     * @brief Launch run() on core 1.
+     */
+    void start()
+    {
+        s_worker = this;
+        multicore_launch_core1(core1Entry);
+    }
+    /**
+     * @brief Execute posted operations forever. Call it from core 1.
+     */
+    void run()
+    {
+        while (true)
+        {
+            if (!poll())
+            {
+                __wfe();
+            }
+        }
+    }
+    /**
+     * @brief Execute all posted operations.
+     *
+     * @return true if any operation was executed.
+     */
+    bool poll()
+    {
+        uint16_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        do
+        {
+            execute(m_queue[tail & (WORKER_QUEUE_DIM - 1)]);
+            tail++;
+            m_tail.store(tail, std::memory_order_release);
+        } while (tail != m_head.load(std::memory_order_acquire));
+        return true;
+    }
+    //----------------------------------------------------------------------------
+    /**
+     * @brief Clear the display and set the cursor to (0, 0).
+     *
+     * @return false if the operation was dropped.
+     */
+    bool clear()
+    {
+        return post(OP_CLEAR_ALL, 0, 0, 0, 0);
+    }
+    /**
+     * @brief Clear a region of the display.
+     *
+     * @param[in] c0 Starting column.
+     * @param[in] c1 Ending column.
+     * @param[in] r0 Starting row;
+     * @param[in] r1 Ending row;
+     * @return false if the operation was dropped.
+     */
+    bool clear(uint8_t c0, uint8_t c1, uint8_t r0, uint8_t r1)
+    {
+        return post(OP_CLEAR, c0, c1, r0, r1);
+    }
+    /**
+     * @brief Set the current font.
+     *
+     * @param[in] font Pointer to a font table.
+     * @return false if the operation was dropped.
+     */
+    bool setFont(const uint8_t *font)
+    {
+        return post(OP_FONT, 0, 0, 0, 0, font);
+    }
+    /**
+     * @brief Set the current font with its table of glyph offsets.
+     *
+     * @param[in] index Glyph offsets of the font, e.g. glyphIndex<Arial14>.
+     * @return false if the operation was dropped.
+     */
+    template <const uint8_t *Table>
+    bool setFont(const GlyphOffsets<Table> &index)
+    {
+        return post(OP_FONT, 0, 0, 0, 0, Table, (void *)index.offset);
+    }
+    /**
+     * @brief Set the current font from a font handle.
+     *
+     * @param[in] font The font handle, e.g. a pagedFont or sparseFont.
+     * @return false if the operation was dropped.
+     */
+    bool setFont(const Font *font)
+    {
+        return post(OP_FONT_HANDLE, 0, 0, 0, 0, font);
+    }
+    /**
+     * @brief Set a chain of fonts, see SSD1306Ascii::setFontChain().
+     *
+     * @param[in] chain The fonts, nullptr to keep only the first font.
+     * @return false if the operation was dropped.
+     */
+    bool setFontChain(FontChain *chain)
+    {
+        return post(OP_FONT_CHAIN, 0, 0, 0, 0, chain);
+    }
+    /**
+     * @brief Copy fonts into RAM when they are set, see
+     *        SSD1306Ascii::setFontArena().
+     *
+     * @param[in] arena The font arena, nullptr to stop copying fonts.
+     * @return false if the operation was dropped.
+     */
+    bool setFontArena(FontArena *arena)
+    {
+        return post(OP_FONT_ARENA, 0, 0, 0, 0, arena);
+    }
+    /**
+     * @brief Set the magnification factors.
+     *
+     * @param[in] x Horizontal factor.
+     * @param[in] y Vertical factor.
+     * @return false if the operation was dropped.
+     */
+    bool setMag(uint8_t x, uint8_t y)
+    {
+        return post(OP_MAG, x, y, 0, 0);
+    }
+    /**
+     * @brief Set UTF-8 mode for printed text.
+     *
+     * @param[in] mode Decode UTF-8 if true, one byte per character if false.
+     * @return false if the operation was dropped.
+     */
+    bool setUtf8Mode(bool mode)
+    {
+        return post(OP_UTF8, mode, 0, 0, 0);
+    }
+    /**
+     * @brief Set the cursor position.
+     *
+     * @param[in] col The column number in pixels.
+     * @param[in] row the row number in eight pixel rows.
+     * @return false if the operation was dropped.
+     */
+    bool setCursor(uint8_t col, uint8_t row)
+    {
+        return post(OP_CURSOR, col, row, 0, 0);
+    }
+    /**
+     * @brief Print text at the cursor.
+     *
+     * @param[in] str The text, copied into the ring.
+     * @return false if the text was dropped.
+     */
+    bool print(const char *str)
+    {
+        return postText(false, 0, 0, str);
+    }
+    /**
+     * @brief Print text at a position.
+     *
+     * @param[in] col The column number in pixels.
+     * @param[in] row the row number in eight pixel rows.
+     * @param[in] str The text, copied into the ring.
+     * @return false if the text was dropped.
+     */
+    bool print(uint8_t col, uint8_t row, const char *str)
+    {
+        return postText(true, col, row, str);
+    }
+    /**
+     * @brief Add text to a ticker queue, see SSD1306Ascii::tickerText().
+     *
+     * @param[in,out] state Ticker state.
+     * @param[in] text Pointer to C string.  Clear queue if nullptr.
+     * @return false if the operation was dropped.
+     */
+    bool tickerText(TickerState *state, const char *text)
+    {
+        return post(OP_TICKER_TEXT, 0, 0, 0, 0, state, (void *)text);
+    }
+    /**
+     * @brief Advance a ticker by one pixel, see SSD1306Ascii::tickerTick().
+     *
+     * @param[in,out] state Ticker state.
+     * @return false if the operation was dropped.
+     */
+    bool tickerTick(TickerState *state)
+    {
+        return post(OP_TICKER_TICK, 0, 0, 0, 0, state);
+    }
+    /**
+     * @brief Run a function with the display on core 1.
+     *
+     * @param[in] fn The function.
+     * @param[in] ctx Argument passed to the function.
+     * @return false if the operation was dropped.
+     */
+    bool call(void (*fn)(SSD1306Ascii &display, void *ctx), void *ctx = nullptr)
+    {
+        return post(OP_CALL, 0, 0, 0, 0, (const void *)fn, ctx);
+    }
+    //----------------------------------------------------------------------------
+    /**
+     * @return Number of operations waiting in the ring.
+     */
+    uint16_t queueDepth() const
+    {
+        return m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed);
+    }
+    /**
+     * @return Highest queue depth seen by the producer.
+     */
+    uint16_t maxQueueDepth() const
+    {
+        return m_maxDepth;
+    }
+    /**
+     * @return Number of operations dropped because the ring was full.
+     */
+    uint32_t droppedOps() const
+    {
+        return m_dropped;
+    }
+
+  private:
+    enum : uint8_t
+    {
+        OP_CLEAR_ALL,
+        OP_CLEAR,
+        OP_FONT,
+        OP_FONT_HANDLE,
+        OP_FONT_CHAIN,
+        OP_FONT_ARENA,
+        OP_MAG,
+        OP_UTF8,
+        OP_CURSOR,
+        OP_TEXT,
+        OP_TEXT_AT,
+        OP_TICKER_TEXT,
+        OP_TICKER_TICK,
+        OP_CALL
+    };
+
+    static void core1Entry()
+    {
+        s_worker->run();
+    }
+
+    void execute(const DisplayOp &op)
+    {
+        switch (op.type)
+        {
+        case OP_CLEAR_ALL:
+            m_display.clear();
+            break;
+        case OP_CLEAR:
+            m_display.clear(op.arg[0], op.arg[1], op.arg[2], op.arg[3]);
+            break;
+        case OP_FONT:
+            m_display.setFont(Font((const uint8_t *)op.ptr, (const uint16_t *)op.ctx));
+            break;
+        case OP_FONT_HANDLE:
+            m_display.setFont(*(const Font *)op.ptr);
+            break;
+        case OP_FONT_CHAIN:
+            m_display.setFontChain((FontChain *)op.ptr);
+            break;
+        case OP_FONT_ARENA:
+            m_display.setFontArena((FontArena *)op.ptr);
+            break;
+        case OP_MAG:
+            m_display.setMag(op.arg[0], op.arg[1]);
+            break;
+        case OP_UTF8:
+            m_display.setUtf8Mode(op.arg[0]);
+            break;
+        case OP_CURSOR:
+            m_display.setCursor(op.arg[0], op.arg[1]);
+            break;
+        case OP_TEXT_AT:
+            m_display.setCursor(op.arg[0], op.arg[1]);
+            // fall through
+        case OP_TEXT:
+            static_cast<Print &>(m_display).write(op.text, strnlen(op.text, WORKER_TEXT_DIM));
+            break;
+        case OP_TICKER_TEXT:
+            m_display.tickerText((TickerState *)op.ptr, (const char *)op.ctx);
+            break;
+        case OP_TICKER_TICK:
+            m_display.tickerTick((TickerState *)op.ptr);
+            break;
+        case OP_CALL:
+            ((void (*)(SSD1306Ascii &, void *))op.ptr)(m_display, op.ctx);
+            break;
+        }
+    }
+
+    // Return the free slot at head or nullptr if n slots are not free.
+    DisplayOp *reserve(uint16_t n)
+    {
+        uint16_t head = m_head.load(std::memory_order_relaxed);
+        uint16_t used = head - m_tail.load(std::memory_order_acquire);
+        if (used + n > WORKER_QUEUE_DIM)
+        {
+            m_dropped++;
+            return nullptr;
+        }
+        if (used + n > m_maxDepth)
+        {
+            m_maxDepth = used + n;
+        }
+        return &m_queue[head & (WORKER_QUEUE_DIM - 1)];
+    }
+
+    // Publish n reserved slots and wake core 1.
+    void commit(uint16_t n)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        __sev();
+    }
+
+    bool post(uint8_t type, uint8_t a0, uint8_t a1, uint8_t a2, uint8_t a3,
+              const void *ptr = nullptr, void *ctx = nullptr)
+    {
+        DisplayOp *op = reserve(1);
+        if (!op)
+        {
+            return false;
+        }
+        op->type = type;
+        op->arg[0] = a0;
+        op->arg[1] = a1;
+        op->arg[2] = a2;
+        op->arg[3] = a3;
+        op->ptr = ptr;
+        op->ctx = ctx;
+        commit(1);
+        return true;
+    }
+
+    // Text longer than one operation is split over consecutive slots.
+    bool postText(bool at, uint8_t col, uint8_t row, const char *str)
+    {
+        size_t len = strlen(str);
+        uint16_t n = len ? (len + WORKER_TEXT_DIM - 1) / WORKER_TEXT_DIM : 1;
+        if (!reserve(n))
+        {
+            return false;
+        }
+        uint16_t head = m_head.load(std::memory_order_relaxed);
+        for (uint16_t i = 0; i < n; i++)
+        {
+            DisplayOp &op = m_queue[(head + i) & (WORKER_QUEUE_DIM - 1)];
+            op.type = at && i == 0 ? OP_TEXT_AT : OP_TEXT;
+            op.arg[0] = col;
+            op.arg[1] = row;
+            strncpy(op.text, str + i * WORKER_TEXT_DIM, WORKER_TEXT_DIM);
+        }
+        commit(n);
+        return true;
+    }
+
+    static inline SSD1306AsciiWorker *s_worker = nullptr;
+
+    SSD1306Ascii &m_display;
+    DisplayOp m_queue[WORKER_QUEUE_DIM];
+    std::atomic<uint16_t> m_head{0}; // Written by core 0 only.
+    std::atomic<uint16_t> m_tail{0}; // Written by core 1 only.
+    uint16_t m_maxDepth = 0;
+    uint32_t m_dropped = 0;
+};
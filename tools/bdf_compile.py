@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+"""Compile a BDF or PCF bitmap font into a font header.
+
+Rows of pixels are transposed into the page-major columns of display RAM,
+each character padded to whole pages, and written as a paged or sparse
+extended font with a table of character offsets:
+
+    bdf_compile.py ter-u16n.bdf --name Terminus16 --range 0x20-0x7E -o Terminus16.h
+
+BDF advance widths include the gap between characters. --spacing moves that
+many blank columns from the end of each character to the letter-spacing of
+the font, which a GLCD proportional font requires to be one pixel.
+"""
+
+import argparse
+import gzip
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import ssd1306_font  # noqa: E402
+
+
+class BitmapGlyph:
+    """A character as parsed: advance, bounding box and rows of pixels.
+
+    rows holds one integer per bounding box row, the leftmost pixel in bit
+    width - 1. x and y place the lower left corner of the box relative to
+    the origin on the baseline.
+    """
+
+    def __init__(self, advance, width, height, x, y, rows):
+        self.advance = advance
+        self.width = width
+        self.height = height
+        self.x = x
+        self.y = y
+        self.rows = rows
+
+
+class BitmapFont:
+    def __init__(self, name, ascent, descent, glyphs):
+        self.name = name
+        self.ascent = ascent
+        self.descent = descent
+        self.glyphs = glyphs
+
+
+def read_bdf(data):
+    """Parse a BDF 2.1 font."""
+    name = 'font'
+    ascent = descent = None
+    box = None
+    glyphs = {}
+    lines = iter(data.decode('latin-1').splitlines())
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        key = words[0]
+        if key == 'FONT' and len(words) > 1:
+            name = words[1]
+        elif key == 'FONTBOUNDINGBOX':
+            box = [int(v) for v in words[1:5]]
+        elif key == 'FONT_ASCENT':
+            ascent = int(words[1])
+        elif key == 'FONT_DESCENT':
+            descent = int(words[1])
+        elif key == 'STARTCHAR':
+            code = advance = bbx = None
+            rows = []
+            for line in lines:
+                words = line.split()
+                if not words:
+                    continue
+                key = words[0]
+                if key == 'ENCODING':
+                    code = int(words[1])
+                    # Unencoded characters may carry a code in a second field.
+                    if code < 0 and len(words) > 2:
+                        code = int(words[2])
+                elif key == 'DWIDTH':
+                    advance = int(words[1])
+                elif key == 'BBX':
+                    bbx = [int(v) for v in words[1:5]]
+                elif key == 'BITMAP':
+                    for line in lines:
+                        if line.strip() == 'ENDCHAR':
+                            break
+                        rows.append(line.strip())
+                    break
+            if bbx is None:
+                raise ssd1306_font.FontError('character %s has no BBX' % code)
+            if code is None or code < 0:
+                continue
+            w, h, x, y = bbx
+            bits = []
+            for row in rows[:h]:
+                value = int(row, 16) if row else 0
+                bits.append(value >> (len(row) * 4 - w) if w else 0)
+            bits += [0] * (h - len(bits))
+            if advance is None:
+                advance = w + max(x, 0)
+            glyphs[code] = BitmapGlyph(advance, w, h, x, y, bits)
+    if ascent is None or descent is None:
+        if box is None:
+            raise ssd1306_font.FontError('the font has no FONTBOUNDINGBOX')
+        ascent, descent = box[1] + box[3], -box[3]
+    return BitmapFont(name, ascent, descent, glyphs)
+
+
+# PCF table types and format flags.
+PCF_PROPERTIES = 1 << 0
+PCF_ACCELERATORS = 1 << 1
+PCF_METRICS = 1 << 2
+PCF_BITMAPS = 1 << 3
+PCF_BDF_ENCODINGS = 1 << 5
+PCF_BDF_ACCELERATORS = 1 << 8
+PCF_GLYPH_PAD_MASK = 3
+PCF_BYTE_MASK = 1 << 2
+PCF_BIT_MASK = 1 << 3
+PCF_SCAN_UNIT_MASK = 3 << 4
+PCF_COMPRESSED_METRICS = 0x100
+
+
+class _PcfTable:
+    def __init__(self, data, offset):
+        self.data = data
+        self.format = struct.unpack_from('<I', data, offset)[0]
+        self.order = '>' if self.format & PCF_BYTE_MASK else '<'
+        self.pos = offset + 4
+
+    def read(self, fmt):
+        values = struct.unpack_from(self.order + fmt, self.data, self.pos)
+        self.pos += struct.calcsize(self.order + fmt)
+        return values if len(values) > 1 else values[0]
+
+
+def _pcf_properties(data, table):
+    t = _PcfTable(data, table)
+    count = t.read('i')
+    props = [t.read('iBi') for _ in range(count)]
+    if count & 3:
+        t.pos += 4 - (count & 3)
+    size = t.read('i')
+    strings = data[t.pos:t.pos + size]
+
+    def string(offset):
+        return strings[offset:strings.index(b'\0', offset)].decode('latin-1')
+    return {string(n): (string(v) if is_string else v) for n, is_string, v in props}
+
+
+def _pcf_row_bits(raw, width, fmt):
+    """Rows of a PCF glyph bitmap as integers, leftmost pixel highest."""
+    unit = 1 << ((fmt & PCF_SCAN_UNIT_MASK) >> 4)
+    msb_byte = bool(fmt & PCF_BYTE_MASK)
+    msb_bit = bool(fmt & PCF_BIT_MASK)
+    raw = bytearray(raw)
+    if msb_byte != msb_bit and unit > 1:
+        for i in range(0, len(raw) - unit + 1, unit):
+            raw[i:i + unit] = raw[i:i + unit][::-1]
+    if not msb_bit:
+        raw = bytearray(int('{:08b}'.format(b)[::-1], 2) for b in raw)
+    value = int.from_bytes(raw, 'big')
+    return value >> (len(raw) * 8 - width) if width else 0
+
+
+def read_pcf(data):
+    """Parse a PCF font as written by bdftopcf."""
+    if data[:4] != b'\x01fcp':
+        raise ssd1306_font.FontError('not a PCF font')
+    count = struct.unpack_from('<I', data, 4)[0]
+    tables = {}
+    for i in range(count):
+        kind, _, _, offset = struct.unpack_from('<4I', data, 8 + 16 * i)
+        tables[kind] = offset
+    for kind in (PCF_METRICS, PCF_BITMAPS, PCF_BDF_ENCODINGS):
+        if kind not in tables:
+            raise ssd1306_font.FontError('the PCF font has no table %d' % kind)
+
+    t = _PcfTable(data, tables[PCF_METRICS])
+    metrics = []
+    if t.format & PCF_COMPRESSED_METRICS:
+        for _ in range(t.read('H')):
+            metrics.append([v - 0x80 for v in t.read('5B')])
+    else:
+        for _ in range(t.read('I')):
+            metrics.append(list(t.read('5hH')[:5]))
+
+    t = _PcfTable(data, tables[PCF_BITMAPS])
+    bitmap_format = t.format
+    n = t.read('I')
+    offsets = [t.read('I') for _ in range(n)]
+    sizes = [t.read('I') for _ in range(4)]
+    bitmaps = t.pos
+    pad = 1 << (bitmap_format & PCF_GLYPH_PAD_MASK)
+    total = sizes[bitmap_format & PCF_GLYPH_PAD_MASK]
+
+    t = _PcfTable(data, tables[PCF_BDF_ENCODINGS])
+    min2, max2, min1, max1, _ = t.read('5h')
+    codes = {}
+    for b1 in range(min1, max1 + 1):
+        for b2 in range(min2, max2 + 1):
+            index = t.read('H')
+            if index != 0xFFFF:
+                codes[b1 << 8 | b2] = index
+
+    accelerators = tables.get(PCF_BDF_ACCELERATORS, tables.get(PCF_ACCELERATORS))
+    if accelerators is not None:
+        t = _PcfTable(data, accelerators)
+        t.pos += 8
+        ascent, descent = t.read('ii')
+    else:
+        props = _pcf_properties(data, tables[PCF_PROPERTIES]) if PCF_PROPERTIES in tables else {}
+        if 'FONT_ASCENT' not in props:
+            raise ssd1306_font.FontError('the PCF font has no ascent')
+        ascent, descent = props['FONT_ASCENT'], props['FONT_DESCENT']
+    name = 'font'
+    if PCF_PROPERTIES in tables:
+        name = _pcf_properties(data, tables[PCF_PROPERTIES]).get('FONT', name)
+
+    glyphs = {}
+    for code, index in codes.items():
+        lsb, rsb, advance, up, down = metrics[index]
+        width, height = rsb - lsb, up + down
+        stride = ((width + 7) // 8 + pad - 1) // pad * pad
+        start = bitmaps + offsets[index]
+        if offsets[index] + stride * height > total:
+            raise ssd1306_font.FontError('the bitmap of character %d is truncated' % code)
+        rows = [_pcf_row_bits(data[start + r * stride:start + (r + 1) * stride], width, bitmap_format)
+                for r in range(height)]
+        glyphs[code] = BitmapGlyph(advance, width, height, lsb, -down, rows)
+    return BitmapFont(name, ascent, descent, glyphs)
+
+
+def read_bitmap_font(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:2] == b'\x1f\x8b':
+        data = gzip.decompress(data)
+    return read_pcf(data) if data[:4] == b'\x01fcp' else read_bdf(data)
+
+
+def paged_font(bitmap, spacing):
+    """Transpose the characters of a bitmap font into paged glyphs."""
+    height = bitmap.ascent + bitmap.descent
+    if not 0 < height < 256:
+        raise ssd1306_font.FontError('font height %d is out of range' % height)
+    rows = (height + 7) // 8
+    glyphs = {}
+    for code, g in bitmap.glyphs.items():
+        width = max(g.advance - spacing, 0)
+        pages = [[0] * width for _ in range(rows)]
+        # Top row of the bounding box counted from the top of the font.
+        top = bitmap.ascent - g.y - g.height
+        for r, bits in enumerate(g.rows):
+            y = top + r
+            if not bits or not 0 <= y < height:
+                continue
+            for c in range(g.width):
+                x = g.x + c
+                if bits >> (g.width - 1 - c) & 1 and 0 <= x < width:
+                    pages[y >> 3][x] |= 1 << (y & 7)
+        glyphs[code] = ssd1306_font.Glyph(width, pages)
+    widths = {g.width for g in glyphs.values()}
+    width = max(widths, default=0)
+    if width > 255:
+        raise ssd1306_font.FontError('character width %d is out of range' % width)
+    return ssd1306_font.Font(bitmap.name, width, height, rows, spacing, len(widths) == 1, glyphs)
+
+
+def _parse_range(text):
+    lo, _, hi = text.partition('-')
+    return int(lo, 0), int(hi or lo, 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('font', help='BDF or PCF font, PCF may be gzip compressed')
+    parser.add_argument('-o', '--output', required=True, help='header to write')
+    parser.add_argument('--name', required=True, help='name of the font table')
+    parser.add_argument('--range', action='append', default=[], type=_parse_range, metavar='FIRST-LAST',
+                        help='keep characters FIRST to LAST, may be repeated, default all')
+    parser.add_argument('--format', choices=('paged', 'sparse', 'glcd'), default='paged',
+                        help='extended paged or sparse font or GLCD layout, default paged')
+    parser.add_argument('--spacing', type=int, default=0,
+                        help='columns of letter-spacing taken from the advance width, default 0')
+    args = parser.parse_args()
+
+    try:
+        bitmap = read_bitmap_font(args.font)
+        if args.range:
+            bitmap.glyphs = {c: g for c, g in bitmap.glyphs.items()
+                             if any(lo <= c <= hi for lo, hi in args.range)}
+        font = paged_font(bitmap, args.spacing)
+        if args.format == 'glcd':
+            sections = ssd1306_font.encode_glcd(font)
+        else:
+            sections = ssd1306_font.encode_extended(font, sparse=args.format == 'sparse')
+    except (OSError, ValueError, struct.error, ssd1306_font.FontError) as e:
+        parser.exit(1, '%s: %s\n' % (parser.prog, e))
+
+    size = sum(len(data) for _, data in sections)
+    description = ['%s - %s, generated by bdf_compile.py' % (args.name, font.name),
+                   '',
+                   'Source: ' + os.path.basename(args.font),
+                   'Characters: %d, height %d, max width %d, letter-spacing %d'
+                   % (len(font.glyphs), font.height, font.width, font.spacing),
+                   'Font size in bytes: %d' % size]
+    ssd1306_font.write_header(args.output, args.name, sections, description)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
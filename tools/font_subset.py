@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Write a font header with only the characters a program displays.
+
+The characters are given on the command line, collected from the string
+literals of source files, or both:
+
+    font_subset.py include/ssd1306_ascii_pico/fonts/Arial14.h \\
+        --name Arial14_digits --chars "0123456789.-" -o Arial14_digits.h
+
+The subset keeps the GLCD layout, with first and count covering the lowest
+to the highest character, or is written as a sparse font with a range table
+and no blank characters.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import ssd1306_font  # noqa: E402
+
+_STRING = re.compile(rb'"((?:\\.|[^"\\\n])*)"')
+_ESCAPE = re.compile(rb'\\(x[0-9a-fA-F]+|[0-7]{1,3}|.)')
+_SIMPLE = {b'n': 10, b't': 9, b'r': 13, b'a': 7, b'b': 8, b'f': 12, b'v': 11}
+
+
+def _unescape(literal):
+    def replace(m):
+        e = m.group(1)
+        if e[:1] == b'x':
+            return bytes([int(e[1:], 16) & 0xFF])
+        if e[:1].isdigit():
+            return bytes([int(e, 8) & 0xFF])
+        return bytes([_SIMPLE.get(e, e[0])])
+    return _ESCAPE.sub(replace, literal)
+
+
+def source_codes(path, utf8):
+    """Characters of the string literals in a source file."""
+    with open(path, 'rb') as f:
+        text = f.read()
+    # Drop comments, keeping strings that contain // or /*.
+    text = re.sub(rb'("(?:\\.|[^"\\\n])*")|/\*.*?\*/|//[^\n]*',
+                  lambda m: m.group(1) or b' ', text, flags=re.S)
+    codes = set()
+    for m in _STRING.finditer(text):
+        data = _unescape(m.group(1))
+        codes.update(map(ord, data.decode('utf-8', 'replace')) if utf8 else data)
+    return codes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('font', help='font header, e.g. fonts/Arial14.h')
+    parser.add_argument('-o', '--output', required=True, help='header to write')
+    parser.add_argument('--name', required=True, help='name of the subset font')
+    parser.add_argument('--font-name', help='font in the header if it holds several')
+    parser.add_argument('--chars', default='', help='characters to keep')
+    parser.add_argument('--source', action='append', default=[],
+                        help='keep the characters of the string literals in a file')
+    parser.add_argument('--utf8', action='store_true', help='source strings are UTF-8')
+    parser.add_argument('--format', choices=('glcd', 'sparse'), default='glcd',
+                        help='GLCD layout or a sparse font, default glcd')
+    args = parser.parse_args()
+
+    try:
+        font = ssd1306_font.read_glcd(args.font, args.font_name)
+        codes = set(map(ord, args.chars))
+        for path in args.source:
+            codes |= source_codes(path, args.utf8)
+        codes = {c for c in codes if c >= 0x20}
+        missing = sorted(c for c in codes if c not in font.glyphs)
+        if missing:
+            print('%s: %s has no %s' % (parser.prog, font.name, ' '.join('U+%04X' % c for c in missing)),
+                  file=sys.stderr)
+        subset = font.subset(codes)
+        if args.format == 'sparse':
+            sections = ssd1306_font.encode_extended(subset, sparse=True)
+        else:
+            sections = ssd1306_font.encode_glcd(subset)
+    except (OSError, ssd1306_font.FontError) as e:
+        parser.exit(1, '%s: %s\n' % (parser.prog, e))
+
+    size = sum(len(data) for _, data in sections)
+    description = ['%s - %d characters of %s, generated by font_subset.py' % (args.name, len(subset.glyphs), font.name),
+                   '',
+                   'Characters: ' + ''.join(chr(c) if 0x20 <= c < 0x7F else '\\u%04X' % c for c in sorted(subset.glyphs)),
+                   'Font size in bytes: %d' % size]
+    ssd1306_font.write_header(args.output, args.name, sections, description)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
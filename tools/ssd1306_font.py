@@ -0,0 +1,280 @@
+"""Font tables of the ssd1306_ascii_pico library.
+
+Reads GLCD font headers such as include/ssd1306_ascii_pico/fonts/Arial14.h,
+holds a font as glyphs in paged form, the column bytes of each page exactly
+as they are written to display RAM, and writes GLCD, paged and sparse font
+headers. The extended formats are described in ssd1306_ascii_font.h.
+"""
+
+import re
+
+# Extended font table layout, see ssd1306_ascii_font.h.
+FONT_EXT_MARK = 0xFF
+FONT_FORMAT_PAGED = 1
+FONT_FORMAT_SPARSE = 2
+
+
+class Glyph:
+    """A character: its width and one list of width column bytes per page."""
+
+    def __init__(self, width, pages):
+        self.width = width
+        self.pages = pages
+
+    def data(self):
+        return [b for page in self.pages for b in page]
+
+
+class Font:
+    """Glyphs by code point with the metrics of the font.
+
+    fixed is true for a GLCD fixed width font. spacing is the default
+    letter-spacing in pixels.
+    """
+
+    def __init__(self, name, width, height, rows, spacing, fixed, glyphs):
+        self.name = name
+        self.width = width
+        self.height = height
+        self.rows = rows
+        self.spacing = spacing
+        self.fixed = fixed
+        self.glyphs = glyphs
+
+    def subset(self, codes):
+        """Return a font with the glyphs of codes only."""
+        glyphs = {c: self.glyphs[c] for c in sorted(codes) if c in self.glyphs}
+        return Font(self.name, self.width, self.height, self.rows, self.spacing, self.fixed, glyphs)
+
+
+class FontError(Exception):
+    pass
+
+
+_TOKEN = re.compile(r"0[xX][0-9a-fA-F]+|\d+|'(?:\\.|[^'\\])+'")
+_ESCAPES = {'n': 10, 't': 9, 'r': 13, '0': 0, '\\': 92, "'": 39, '"': 34}
+
+
+def _strip_comments(text):
+    text = re.sub(r'/\*.*?\*/', lambda m: '\n' * m.group(0).count('\n') or ' ', text, flags=re.S)
+    return re.sub(r'//[^\n]*', ' ', text)
+
+
+def _preprocess(text):
+    """Keep the lines selected by #if, #ifdef and #ifndef of simple macros."""
+    defines = {}
+    keep = [True]
+    taken = [True]
+    lines = []
+    for line in text.split('\n'):
+        m = re.match(r'\s*#\s*(\w+)\s*(.*?)\s*$', line)
+        if not m:
+            if all(keep):
+                lines.append(line)
+            continue
+        directive, arg = m.groups()
+        if directive == 'define' and all(keep):
+            name, _, value = arg.partition(' ')
+            defines[name] = value.strip() or '1'
+        elif directive in ('if', 'ifdef', 'ifndef'):
+            if directive == 'if':
+                negate = arg.startswith('!')
+                value = defines.get(arg.lstrip('!').strip(), arg.lstrip('!').strip())
+                cond = (value.isdigit() and int(value) != 0) != negate
+            else:
+                cond = (arg in defines) == (directive == 'ifdef')
+            keep.append(cond)
+            taken.append(cond)
+        elif directive == 'else':
+            keep[-1] = not taken[-1]
+        elif directive == 'endif':
+            keep.pop()
+            taken.pop()
+    return '\n'.join(lines)
+
+
+def _char_value(literal):
+    body = literal[1:-1]
+    if body.startswith('\\'):
+        if body[1] in 'xX':
+            return int(body[2:], 16)
+        if body[1:].isdigit():
+            return int(body[1:], 8)
+        return _ESCAPES[body[1]]
+    return ord(body)
+
+
+def parse_glcd_tables(text):
+    """Return {name: [bytes]} of the GLCDFONTDECL arrays in a header."""
+    text = _preprocess(_strip_comments(text))
+    tables = {}
+    for m in re.finditer(r'GLCDFONTDECL\s*\(\s*(\w+)\s*\)\s*=\s*\{(.*?)\}\s*;', text, re.S):
+        values = []
+        for token in _TOKEN.findall(m.group(2)):
+            values.append(_char_value(token) if token.startswith("'") else int(token, 0))
+        tables[m.group(1)] = values
+    return tables
+
+
+def decode_glcd(name, table):
+    """Decode a GLCD fixed width or Thiele font table."""
+    if table[0] == FONT_EXT_MARK:
+        raise FontError('%s is not a GLCD font' % name)
+    font_type = table[0] << 8 | table[1]
+    width, height, first, count = table[2:6]
+    rows = (height + 7) // 8
+    fixed = font_type < 2
+    spacing = 0 if font_type == 1 else 1
+    shift = 0 if fixed or not height & 7 else 8 - (height & 7)
+    widths = [width] * count if fixed else table[6:6 + count]
+    offset = 6 if fixed else 6 + count
+    glyphs = {}
+    for i, w in enumerate(widths):
+        data = table[offset:offset + rows * w]
+        if len(data) != rows * w:
+            raise FontError('%s is truncated at character %d' % (name, first + i))
+        pages = [data[r * w:(r + 1) * w] for r in range(rows)]
+        if shift:
+            pages[-1] = [b >> shift for b in pages[-1]]
+        glyphs[first + i] = Glyph(w, pages)
+        offset += rows * w
+    return Font(name, width, height, rows, spacing, fixed, glyphs)
+
+
+def read_glcd(path, name=None):
+    """Read a font from a header, the only table or the table called name."""
+    with open(path, encoding='latin-1') as f:
+        tables = parse_glcd_tables(f.read())
+    if not tables:
+        raise FontError('no GLCDFONTDECL table in %s' % path)
+    if name is None:
+        if len(tables) > 1:
+            raise FontError('%s has several fonts, select one of %s' % (path, ', '.join(tables)))
+        name = next(iter(tables))
+    if name not in tables:
+        raise FontError('%s has no font %s' % (path, name))
+    return decode_glcd(name, tables[name])
+
+
+def _le16(v):
+    return [v & 0xFF, v >> 8]
+
+
+def encode_glcd(font):
+    """GLCD table of a font, characters missing in a range are left blank.
+
+    Returns a list of (comment, bytes) sections.
+    """
+    codes = sorted(font.glyphs)
+    if not codes or codes[-1] > 0xFF:
+        raise FontError('a GLCD font holds characters 0 to 255')
+    first, count = codes[0], codes[-1] - codes[0] + 1
+    blank = Glyph(font.width if font.fixed else 0, [[0] * (font.width if font.fixed else 0)] * font.rows)
+    glyphs = [font.glyphs.get(first + i, blank) for i in range(count)]
+    sections = []
+    if font.fixed:
+        header = [0, 0 if font.spacing else 1]
+        sections.append(('size of zero indicates fixed width font', header))
+    else:
+        if font.spacing != 1:
+            raise FontError('a proportional GLCD font has one pixel of letter-spacing')
+        size = 6 + count + sum(font.rows * g.width for g in glyphs)
+        sections.append(('size', [min(size, 0xFEFF) >> 8, min(size, 0xFEFF) & 0xFF]))
+    sections += [('width', [font.width]), ('height', [font.height]),
+                 ('first char', [first]), ('char count', [count])]
+    if not font.fixed:
+        sections.append(('char widths', [g.width for g in glyphs]))
+    shift = 0 if font.fixed or not font.height & 7 else 8 - (font.height & 7)
+    for i, g in enumerate(glyphs):
+        pages = [list(p) for p in g.pages]
+        if shift and pages:
+            pages[-1] = [(b << shift) & 0xFF for b in pages[-1]]
+        sections.append((_char_comment(first + i), [b for p in pages for b in p]))
+    return sections
+
+
+def _ranges(codes):
+    ranges = []
+    for c in codes:
+        if ranges and ranges[-1][1] == c - 1:
+            ranges[-1][1] = c
+        else:
+            ranges.append([c, c])
+    return ranges
+
+
+def encode_extended(font, sparse):
+    """Paged or sparse extended table of a font, a list of (comment, bytes).
+
+    A paged font covers the characters from the first to the last one and
+    leaves missing characters blank, a sparse font has ranges instead.
+    """
+    codes = sorted(font.glyphs)
+    if not codes:
+        raise FontError('the font has no characters')
+    if sparse:
+        ranges = _ranges(codes)
+        if len(ranges) > 255 or codes[-1] > 0xFFFF:
+            raise FontError('a sparse font holds 255 ranges of characters 0 to 0XFFFF')
+    else:
+        if codes[-1] > 0xFF:
+            raise FontError('a paged font holds characters 0 to 255')
+        ranges = [[codes[0], codes[-1]]]
+        codes = list(range(codes[0], codes[-1] + 1))
+    blank = Glyph(0, [[] for _ in range(font.rows)])
+    glyphs = [font.glyphs.get(c, blank) for c in codes]
+    count = len(glyphs)
+    sections = [('extended font', [FONT_EXT_MARK, FONT_FORMAT_SPARSE if sparse else FONT_FORMAT_PAGED]),
+                ('width', [font.width]), ('height', [font.height])]
+    if sparse:
+        sections.append(('char count', _le16(count)))
+    else:
+        sections += [('first char', [codes[0]]), ('char count', [count])]
+    sections += [('rows', [font.rows]), ('letter-spacing', [font.spacing])]
+    if sparse:
+        sections.append(('range count', [len(ranges)]))
+        index = 0
+        for lo, hi in ranges:
+            sections.append(('range U+%04X - U+%04X' % (lo, hi), _le16(lo) + _le16(hi - lo + 1) + _le16(index)))
+            index += hi - lo + 1
+    sections.append(('char widths', [g.width for g in glyphs]))
+    offsets = []
+    offset = 0
+    for g in glyphs:
+        offsets += _le16(offset)
+        offset += len(g.data())
+    if offset > 0xFFFF:
+        raise FontError('the character data exceeds 64 KiB')
+    sections.append(('char offsets', offsets))
+    for c, g in zip(codes, glyphs):
+        if g.width:
+            sections.append((_char_comment(c), g.data()))
+    return sections
+
+
+def _char_comment(code):
+    if 0x20 < code < 0x7F and chr(code) not in '\\':
+        return "char '%s'" % chr(code)
+    return 'char U+%04X' % code
+
+
+def write_header(path, name, sections, description):
+    """Write a font header in the layout of the bundled fonts."""
+    guard = re.sub(r'\W', '_', name).upper() + '_H'
+    lines = ['/*']
+    lines += [(' * ' + line).rstrip() for line in description]
+    lines += [' */', '', '#ifndef ' + guard, '#define ' + guard, '',
+              '#include <cstdint>', '', '#include <ssd1306_ascii_pico/fonts/allFonts.h>', '',
+              'GLCDFONTDECL(%s) = {' % name]
+    for comment, data in sections:
+        if not data:
+            continue
+        if len(data) <= 2:
+            lines.append('    %s // %s' % (' '.join('0x%02X,' % b for b in data), comment))
+            continue
+        lines.append('    // ' + comment)
+        for i in range(0, len(data), 12):
+            lines.append('    ' + ' '.join('0x%02X,' % b for b in data[i:i + 12]))
+    lines += ['};', '', '#endif // ' + guard, '']
+    with open(path, 'w', encoding='ascii', newline='\n') as f:
+        f.write('\n'.join(lines))